@@ -0,0 +1,117 @@
+#!/bin/bash
+
+# ruleaza tema2 pe workload-uri generate de marimi crescatoare si scrie cate o linie CSV
+# per rulare (timpi si numar de mesaje), ca regresiile de scalare sa apara ca numere:
+#
+#   ./bench.sh [np ...] [-- optiuni tema2]
+#   ex: FILES=32 CHUNKS=500 ./bench.sh 8 16 32 64 -- --trackers 2 --chunk-size 4096
+#
+# parametrii workload-ului (vezi gen_workload.cpp) vin din mediu: FILES, CHUNKS, SEED_RATIO,
+# OWNED, WANTED, ZIPF, SHARED, SEED; rezultatele ajung in $OUT (implicit bench.csv)
+
+FILES=${FILES:-8}
+CHUNKS=${CHUNKS:-100}
+SEED_RATIO=${SEED_RATIO:-0.25}
+OWNED=${OWNED:-2}
+WANTED=${WANTED:-2}
+ZIPF=${ZIPF:-1.0}
+SHARED=${SHARED:-0}
+SEED=${SEED:-1}
+OUT=${OUT:-bench.csv}
+TIMEOUT=${TIMEOUT:-300}
+
+sizes=()
+while [ $# -gt 0 ] && [ "$1" != "--" ]
+do
+    sizes+=("$1")
+    shift
+done
+[ "$1" == "--" ] && shift
+[ ${#sizes[@]} == 0 ] && sizes=(4 8 16 32)
+
+# numarul de tracker-e trebuie stiut si de generator
+trackers=1
+args=("$@")
+for ((i = 0; i < ${#args[@]}; i++))
+do
+    [ "${args[$i]}" == "--trackers" ] && trackers=${args[$((i + 1))]}
+done
+
+export OMPI_ALLOW_RUN_AS_ROOT=1
+export OMPI_ALLOW_RUN_AS_ROOT_CONFIRM=1
+
+# valoarea unui contor din "totals"
+function total {
+    grep '"totals"' $1 | grep -o "\"$2\": [0-9]*" | awk '{print $2}'
+}
+
+# maximul unui contor peste rank-uri (durata unei faze e a celui mai lent)
+function rank_max {
+    grep '"rank"' $1 | grep -o "\"$2\": [0-9]*" | awk 'BEGIN {m = 0} {if ($2 > m) m = $2} END {print m}'
+}
+
+# un rezultat per np (parametru: np)
+function run_size {
+    np=$1
+    dir=$(mktemp -d)
+
+    ../src/gen_workload $dir --ranks $np --trackers $trackers --files $FILES --chunks $CHUNKS \
+        --seed-ratio $SEED_RATIO --owned $OWNED --wanted $WANTED --zipf $ZIPF --shared $SHARED --seed $SEED > /dev/null
+    if [ $? != 0 ]
+    then
+        echo "W: Nu s-a putut genera workload-ul pentru np=$np"
+        rm -rf $dir
+        return
+    fi
+    cp tema2 $dir
+
+    start=$(date +%s.%N)
+    (cd $dir && timeout $TIMEOUT mpirun --oversubscribe -np $np ./tema2 --report report.json "${args[@]}" &> run.txt)
+    ret=$?
+    end=$(date +%s.%N)
+
+    if [ $ret != 0 ] || [ ! -f $dir/report.json ]
+    then
+        echo "W: Rularea cu np=$np a esuat (cod $ret)"
+        tail -5 $dir/run.txt
+        rm -rf $dir
+        return
+    fi
+
+    r=$dir/report.json
+    line="$np,$((np - trackers)),$(awk "BEGIN {printf \"%.3f\", $end - $start}")"
+    line="$line,$(rank_max $r init_us),$(rank_max $r download_us)"
+    for c in tracker_msgs swarm_polls swarm_pushes chunks_received chunks_failed choked_received \
+             have_served endgame_duplicates chunks_local bytes_sent
+    do
+        line="$line,$(total $r $c)"
+    done
+    line="$line,$(grep -o '"payload_mb_s": [0-9.]*' $r | awk '{print $2}')"
+
+    echo "$line" >> $OUT
+    echo "np=$np: $line"
+    rm -rf $dir
+}
+
+# se compileaza tema si generatorul
+cd ../src
+make build &> build.txt && make gen &>> build.txt
+if [ ! -f tema2 ] || [ ! -f gen_workload ]
+then
+    echo "E: Nu s-a putut compila"
+    cat build.txt
+    rm -rf build.txt
+    exit 1
+fi
+rm -rf build.txt
+mv tema2 ../checker
+cd ../checker
+
+echo "np,peers,wall_s,init_us_max,download_us_max,tracker_msgs,swarm_polls,swarm_pushes,chunks_received,chunks_failed,choked_received,have_served,endgame_duplicates,chunks_local,bytes_sent,payload_mb_s" > $OUT
+for np in "${sizes[@]}"
+do
+    run_size $np
+done
+
+rm -rf tema2 ../src/gen_workload
+echo "Rezultate in $OUT"
@@ -5,7 +5,7 @@ total=0
 
 # afiseaza scorul final
 function show_score {
-	echo "Total: $total/40"
+	echo "Total: $total/60"
 }
 
 function run_timeout {
@@ -129,6 +129,75 @@ function test4 {
 	echo ""
 }
 
+# generat cu "gen_workload --ranks 7 --files 4 --chunks 40 --seed-ratio 0.34 --shared 0.3 --seed 5":
+# o parte din chunk-urile fisierelor 2-4 repeta chunk-uri din fisierele anterioare
+function test5 {
+	echo "Se ruleaza testul 5..."
+	cp tests/test5/* .
+	correct=0
+	run_timeout "mpirun --oversubscribe -np 7 ./tema2"
+	compare_files client2_file1 out1.txt
+	compare_files client2_file2 out2.txt
+	compare_files client3_file1 out1.txt
+	compare_files client3_file2 out2.txt
+	compare_files client5_file1 out1.txt
+	compare_files client5_file3 out3.txt
+	compare_files client6_file1 out1.txt
+	compare_files client6_file3 out3.txt
+	if [ $correct == 8 ]
+	then
+	    total=$((total+10))
+	    echo "OK"
+	else
+		echo "Testul 5 a picat"
+	fi
+	rm -rf client*_file*
+	rm -rf in*txt
+	rm -rf out*txt
+	echo ""
+}
+
+# inputul testului 1, dar clientul 2 reia file1 dintr-o rulare intrerupta: chunk-urile 0-59 sunt
+# marcate in client2_file1.progress, iar chunk-ul 17 are un hash gresit in output. Chunk-ul 17
+# trebuie cerut din nou, output-ul trebuie sa fie identic cu out1.txt, iar fisierul de progres sters
+function test6 {
+	echo "Se ruleaza testul 6..."
+	cp tests/test6/* .
+	correct=0
+	run_timeout "mpirun --oversubscribe -np 4 ./tema2 --report report.json"
+	if cmp -s client2_file1 out1.txt
+	then
+		correct=$((correct+1))
+	else
+		echo "W: Exista diferente intre fisierele client2_file1 si out1.txt"
+	fi
+	if [ ! -f client2_file1.progress ]
+	then
+		correct=$((correct+1))
+	else
+		echo "W: Fisierul client2_file1.progress nu a fost sters"
+	fi
+	client2=$(grep '"rank": 2,' report.json)
+	if echo "$client2" | grep -q '"chunks_resumed": 59,' && echo "$client2" | grep -q '"chunks_received": 41,'
+	then
+		correct=$((correct+1))
+	else
+		echo "W: Clientul 2 trebuia sa reia 59 de chunk-uri si sa descarce 41"
+	fi
+	if [ $correct == 3 ]
+	then
+	    total=$((total+10))
+	    echo "OK"
+	else
+		echo "Testul 6 a picat"
+	fi
+	rm -rf client*_file*
+	rm -rf in*txt
+	rm -rf out*txt
+	rm -rf report.json
+	echo ""
+}
+
 # printeaza informatii despre rulare
 #echo "VMCHECKER_TRACE_CLEANUP"
 date
@@ -160,6 +229,8 @@ test1
 test2
 test3
 test4
+test5
+test6
 
 make clean &> /dev/null
 
@@ -0,0 +1,157 @@
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <queue>
+#include <random>
+#include <vector>
+#include <algorithm>
+#include "struct.h"
+#include "selector.h"
+
+using namespace std;
+
+/* compara alegerea adaptiva a sursei cu euristica veche, intr-o simulare fara MPI: un peer
+descarca "nr_chunks" chunk-uri cu "window" cereri in curs, de la "nr_sources" surse care au tot
+fisierul. Fiecare sursa e o coada FIFO cu timp de servire exponential; o parte din surse sunt
+lente (de "slow_factor" ori), iar altele sunt supraincarcate si refuza o parte din cereri
+(raspuns rapid, dar cererea trebuie repetata).
+
+    make bench && ./bench_selector [nr_sources] [window] [nr_chunks] [seed] */
+
+struct sim_source {
+    double service_ns;  // media timpului de servire
+    double refuse_prob; // probabilitatea unui raspuns "choked"
+    double busy_until;  // cand isi termina coada curenta
+};
+
+struct sim_response {
+    double done_ns;
+    double sent_ns;
+    int source;
+    bool ok;
+
+    bool operator>(const sim_response& other) const {
+        return done_ns > other.done_ns;
+    }
+};
+
+struct sim_result {
+    double makespan_ns;
+    double mean_ns;
+    double p99_ns;
+    int nr_refused;
+    int nr_slow_picks;
+};
+
+static const double NET_LATENCY_NS = 50000;
+static const double SERVICE_NS = 100000;
+
+static vector<sim_source> make_sources(int nr_sources, double slow_factor, unsigned seed) {
+    mt19937 gen(seed);
+    vector<sim_source> sources(nr_sources);
+
+    for (int s = 0; s < nr_sources; s++) {
+        sources[s] = {SERVICE_NS, 0, 0};
+        int kind = gen() % 8;
+        if (kind < 2) {
+            sources[s].service_ns = SERVICE_NS * slow_factor; // 25% lente
+        } else if (kind == 2) {
+            sources[s].refuse_prob = 0.5;                     // 12.5% supraincarcate
+        }
+    }
+    return sources;
+}
+
+static sim_result simulate(bool adaptive, vector<sim_source> sources, int window, int nr_chunks, unsigned seed) {
+    mt19937 gen(seed);
+    srand(seed);
+
+    SourceSelector selector;
+    selector.init(sources.size(), adaptive);
+
+    priority_queue<sim_response, vector<sim_response>, greater<sim_response>> pending;
+    vector<double> latencies;
+    sim_result result = {0, 0, 0, 0, 0};
+    int nr_done = 0;
+    int nr_requested = 0;
+    double now = 0;
+
+    auto send = [&](double t) {
+        int s = selector.pick([](int) { return true; });
+        sim_source& src = sources[s];
+        selector.on_request(s);
+        nr_requested++;
+        result.nr_slow_picks += src.service_ns > SERVICE_NS;
+
+        sim_response res = {0, t, s, true};
+        if (uniform_real_distribution<double>(0, 1)(gen) < src.refuse_prob) {
+            // refuzul nu intra in coada sursei
+            res.ok = false;
+            res.done_ns = t + 2 * NET_LATENCY_NS;
+        } else {
+            double start = max(t + NET_LATENCY_NS, src.busy_until);
+            src.busy_until = start + exponential_distribution<double>(1.0 / src.service_ns)(gen);
+            res.done_ns = src.busy_until + NET_LATENCY_NS;
+        }
+        pending.push(res);
+    };
+
+    for (int i = 0; i < window && nr_requested < nr_chunks; i++) {
+        send(0);
+    }
+
+    while (!pending.empty()) {
+        sim_response res = pending.top();
+        pending.pop();
+        now = res.done_ns;
+
+        selector.on_response(res.source, (uint64_t)(res.done_ns - res.sent_ns), res.ok);
+        if (res.ok) {
+            latencies.push_back(res.done_ns - res.sent_ns);
+            nr_done++;
+        } else {
+            result.nr_refused++;
+            nr_requested--; // chunk-ul se cere din nou
+        }
+
+        if (nr_requested < nr_chunks) {
+            send(now);
+        }
+    }
+
+    sort(latencies.begin(), latencies.end());
+    double sum = 0;
+    for (double l : latencies) {
+        sum += l;
+    }
+
+    result.makespan_ns = now;
+    result.mean_ns = sum / latencies.size();
+    result.p99_ns = latencies[(size_t)(0.99 * (latencies.size() - 1))];
+    return result;
+}
+
+int main(int argc, char* argv[]) {
+    int nr_sources = argc > 1 ? atoi(argv[1]) : 32;
+    int window = argc > 2 ? atoi(argv[2]) : DOWNLOAD_WINDOW;
+    int nr_chunks = argc > 3 ? atoi(argv[3]) : 20000;
+    unsigned seed = argc > 4 ? atoi(argv[4]) : 1;
+
+    printf("sources=%d window=%d chunks=%d seed=%u\n", nr_sources, window, nr_chunks, seed);
+    printf("%-8s %-10s %12s %12s %12s %12s %10s %10s\n", "slow_x", "selector", "makespan_ms",
+           "chunks/s", "mean_us", "p99_us", "refused", "slow_pct");
+
+    double slow_factors[] = {1, 4, 10, 50};
+    for (double slow_factor : slow_factors) {
+        vector<sim_source> sources = make_sources(nr_sources, slow_factor, seed);
+
+        for (int adaptive = 0; adaptive <= 1; adaptive++) {
+            sim_result r = simulate(adaptive, sources, window, nr_chunks, seed);
+            printf("%-8.0f %-10s %12.2f %12.0f %12.1f %12.1f %10d %9.1f%%\n", slow_factor,
+                   adaptive ? "adaptive" : "legacy", r.makespan_ns / 1e6, nr_chunks / (r.makespan_ns / 1e9),
+                   r.mean_ns / 1e3, r.p99_ns / 1e3, r.nr_refused, 100.0 * r.nr_slow_picks / (nr_chunks + r.nr_refused));
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,270 @@
+#include <mpi.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+#include <algorithm>
+#include "struct.h"
+#include "peer.h"
+#include "transport.h"
+#include "progress.h"
+
+using namespace std;
+
+/* compara ratele de mesaje ale transporturilor (vezi transport.h), pe tiparele din tema2:
+rank-urile 1 .. np - 1 sunt clienti, iar rank-ul 0 le serveste cu "window" receive-uri
+persistente, ca thread-ul de upload.
+ - stream: clientii trimit "nr_msgs" cereri de chunk (sizeof(chunk_request) octeti) fara sa
+   astepte raspuns, cu cel mult "window" trimiteri in curs
+ - request/response: fiecare client tine "window" cereri in curs, iar rank-ul 0 raspunde la
+   fiecare cu un chunk_response si "payload" octeti, pe tag-ul slot-ului, ca la descarcare;
+   cu "gap_us" clientul asteapta atat inainte de fiecare cerere noua (trafic rar, us/msg include
+   pauza), ca sa se vada cat intarzie un raspuns care gaseste celalalt capat fara nimic de facut
+"proxy" e transportul MPI folosit dintr-un thread de lucru prin motorul de progres (progress.h),
+ca la --comm-thread 1; "mpi" il apeleaza direct, ca la --comm-thread 0.
+
+    make bench_transport && mpirun -np 2 ./bench_transport [nr_msgs] [payload] [window] [gap_us] */
+
+struct bench_result {
+    double seconds;
+    long nr_msgs;
+};
+
+// rank-ul 0 primeste pana la nr_msgs mesaje de la fiecare client
+static bench_result run_stream(Transport* t, int rank, int numtasks, int nr_msgs, int window) {
+    vector<chunk_request> bufs(window);
+    vector<xfer_request> reqs(window);
+    vector<xfer_status> statuses(window);
+    vector<int> done(window);
+    bench_result result = {0, (long)nr_msgs * (numtasks - 1)};
+
+    if (rank == 0) {
+        for (int i = 0; i < window; i++) {
+            t->recv_init(&bufs[i], sizeof(chunk_request), XFER_ANY_SOURCE, MSG_CHUNK_REQUEST, reqs[i]);
+            t->start(reqs[i]);
+        }
+    }
+    MPI_Barrier(MPI_COMM_WORLD);
+    double start = MPI_Wtime();
+
+    if (rank == 0) {
+        long received = 0;
+        while (received < result.nr_msgs) {
+            int nr_done;
+            t->waitsome(window, reqs.data(), nr_done, done.data(), statuses.data());
+            for (int d = 0; d < nr_done; d++) {
+                received++;
+                t->start(reqs[done[d]]);
+            }
+        }
+        result.seconds = MPI_Wtime() - start;
+
+        for (int i = 0; i < window; i++) {
+            t->cancel(reqs[i]);
+        }
+    } else {
+        for (int i = 0; i < nr_msgs; i++) {
+            int s = i % window;
+            t->wait(reqs[s], nullptr);
+            bufs[s].type = REQUEST_CHUNK;
+            bufs[s].chunk_index = i;
+            t->isend(&bufs[s], sizeof(chunk_request), 0, MSG_CHUNK_REQUEST, reqs[s]);
+        }
+        for (int i = 0; i < window; i++) {
+            t->wait(reqs[i], nullptr);
+        }
+    }
+
+    MPI_Barrier(MPI_COMM_WORLD);
+    return result;
+}
+
+static bench_result run_request_response(Transport* t, int rank, int numtasks, int nr_msgs, int payload, int window,
+                                         int gap_us) {
+    vector<chunk_request> reqs(window);
+    vector<chunk_response> responses(window);
+    vector<char> data((size_t)window * payload + 1, 'x');
+    vector<xfer_request> recv_reqs(window), payload_reqs(window), send_reqs(window);
+    vector<xfer_status> statuses(window);
+    vector<int> done(window);
+    bench_result result = {0, (long)nr_msgs * (numtasks - 1)};
+
+    if (rank == 0) {
+        for (int i = 0; i < window; i++) {
+            t->recv_init(&reqs[i], sizeof(chunk_request), XFER_ANY_SOURCE, MSG_CHUNK_REQUEST, recv_reqs[i]);
+            t->start(recv_reqs[i]);
+        }
+    }
+
+    // clientul: cererea din slot-ul s primeste raspunsul pe tag-ul MSG_CHUNK_RESPONSE + s
+    auto issue = [&](int s, int index) {
+        reqs[s].type = REQUEST_CHUNK;
+        reqs[s].chunk_index = index;
+        reqs[s].token = s;
+        t->irecv(&responses[s], sizeof(chunk_response), 0, MSG_CHUNK_RESPONSE + s, recv_reqs[s]);
+        if (payload > 0) {
+            t->irecv(data.data() + (size_t)s * payload, payload, 0, MSG_CHUNK_RESPONSE + s, payload_reqs[s]);
+        }
+        t->isend(&reqs[s], sizeof(chunk_request), 0, MSG_CHUNK_REQUEST, send_reqs[s]);
+    };
+
+    MPI_Barrier(MPI_COMM_WORLD);
+    double start = MPI_Wtime();
+
+    if (rank == 0) {
+        long served = 0;
+        while (served < result.nr_msgs) {
+            int nr_done;
+            t->waitsome(window, recv_reqs.data(), nr_done, done.data(), statuses.data());
+            for (int d = 0; d < nr_done; d++) {
+                int s = done[d];
+                t->wait(send_reqs[s], nullptr);
+                t->wait(payload_reqs[s], nullptr);
+
+                responses[s].has_chunk = true;
+                responses[s].choked = false;
+                responses[s].chunk_index = reqs[s].chunk_index;
+                int tag = MSG_CHUNK_RESPONSE + reqs[s].token;
+                t->isend(&responses[s], sizeof(chunk_response), statuses[d].source, tag, send_reqs[s]);
+                if (payload > 0) {
+                    t->isend(data.data() + (size_t)s * payload, payload, statuses[d].source, tag, payload_reqs[s]);
+                }
+                served++;
+                t->start(recv_reqs[s]);
+            }
+        }
+        result.seconds = MPI_Wtime() - start;
+
+        for (int i = 0; i < window; i++) {
+            t->cancel(recv_reqs[i]);
+            t->wait(send_reqs[i], nullptr);
+            t->wait(payload_reqs[i], nullptr);
+        }
+    } else {
+        int issued = 0;
+        int completed = 0;
+        for (; issued < min(window, nr_msgs); issued++) {
+            issue(issued, issued);
+        }
+
+        while (completed < nr_msgs) {
+            int nr_done;
+            t->waitsome(window, recv_reqs.data(), nr_done, done.data(), statuses.data());
+            for (int d = 0; d < nr_done; d++) {
+                int s = done[d];
+                t->wait(send_reqs[s], nullptr);
+                t->wait(payload_reqs[s], nullptr);
+                completed++;
+                if (issued < nr_msgs) {
+                    if (gap_us > 0) {
+                        usleep(gap_us);
+                    }
+                    issue(s, issued++);
+                }
+            }
+        }
+    }
+
+    MPI_Barrier(MPI_COMM_WORLD);
+    return result;
+}
+
+// o rulare a ambelor teste pe un transport
+struct bench_job {
+    ProgressEngine* engine;
+    Transport* t;
+    int rank;
+    int numtasks;
+    int nr_msgs;
+    int payload;
+    int window;
+    int gap_us;
+    bench_result stream;
+    bench_result rr;
+};
+
+static void run_all(bench_job& job) {
+    job.stream = run_stream(job.t, job.rank, job.numtasks, job.nr_msgs, job.window);
+    job.rr = run_request_response(job.t, job.rank, job.numtasks, job.nr_msgs, job.payload, job.window, job.gap_us);
+}
+
+// thread-ul de lucru al transportului "proxy", cat timp thread-ul principal e motorul
+static void* proxy_thread_func(void* arg) {
+    bench_job* job = static_cast<bench_job*>(arg);
+    job->engine->attach();
+    run_all(*job);
+    job->engine->detach();
+    return nullptr;
+}
+
+int main(int argc, char* argv[]) {
+    int provided;
+    MPI_Init_thread(&argc, &argv, MPI_THREAD_MULTIPLE, &provided);
+
+    int rank, numtasks;
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    MPI_Comm_size(MPI_COMM_WORLD, &numtasks);
+
+    int nr_msgs = argc > 1 ? atoi(argv[1]) : 200000;
+    int payload = argc > 2 ? max(atoi(argv[2]), 0) : 0;
+    int window = argc > 3 ? max(atoi(argv[3]), 1) : DOWNLOAD_WINDOW;
+    int gap_us = argc > 4 ? max(atoi(argv[4]), 0) : 0;
+
+    if (numtasks < 2) {
+        fprintf(stderr, "Run with at least 2 ranks (mpirun -np 2 ./bench_transport)\n");
+        MPI_Finalize();
+        return 1;
+    }
+
+    if (rank == 0) {
+        printf("clients=%d msgs=%d payload=%d window=%d gap_us=%d\n", numtasks - 1, nr_msgs, payload, window, gap_us);
+        printf("%-10s %-18s %12s %12s %12s %12s\n", "transport", "test", "seconds", "msgs/s", "us/msg", "MB/s");
+    }
+
+    const char* kinds[] = {"mpi", "proxy", "shm"};
+    for (const char* kind : kinds) {
+        bool proxy = strcmp(kind, "proxy") == 0;
+        const char* inner = proxy ? "mpi" : kind;
+        Transport* t = create_transport(inner, payload);
+        if (strcmp(t->name(), inner) != 0) {
+            if (rank == 0) {
+                printf("%-10s unavailable\n", kind);
+            }
+            delete t;
+            continue;
+        }
+
+        bench_job job = {nullptr, t, rank, numtasks, nr_msgs, payload, window, gap_us, {0, 0}, {0, 0}};
+        if (proxy) {
+            ProgressEngine engine;
+            pthread_t thread;
+            job.engine = &engine;
+            job.t = funnel_transport(&engine, t);
+            if (pthread_create(&thread, nullptr, proxy_thread_func, &job) != 0) {
+                fprintf(stderr, "Error creating benchmark thread\n");
+                MPI_Abort(MPI_COMM_WORLD, 1);
+            }
+            engine.run(1);
+            pthread_join(thread, nullptr);
+        } else {
+            run_all(job);
+        }
+        bench_result stream = job.stream;
+        bench_result rr = job.rr;
+
+        if (rank == 0) {
+            printf("%-10s %-18s %12.3f %12.0f %12.2f %12.1f\n", kind, "stream", stream.seconds,
+                   stream.nr_msgs / stream.seconds, 1e6 * stream.seconds / stream.nr_msgs,
+                   stream.nr_msgs * sizeof(chunk_request) / stream.seconds / 1e6);
+            printf("%-10s %-18s %12.3f %12.0f %12.2f %12.1f\n", kind, "request/response", rr.seconds,
+                   rr.nr_msgs / rr.seconds, 1e6 * rr.seconds / rr.nr_msgs,
+                   rr.nr_msgs * (double)(sizeof(chunk_request) + sizeof(chunk_response) + payload) / rr.seconds / 1e6);
+        }
+        delete job.t;
+    }
+
+    MPI_Finalize();
+    return 0;
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <stdint.h>
+#include <vector>
+
+// set de biti impachetat in cuvinte de 64 de biti (ex: ce rank-uri sunt seed pentru un fisier)
+struct bitmap {
+    int nr_bits = 0;
+    std::vector<uint64_t> words;
+
+    static int words_for(int n) {
+        return (n + 63) / 64;
+    }
+
+    void resize(int n) {
+        nr_bits = n;
+        words.assign(words_for(n), 0);
+    }
+
+    bool test(int i) const {
+        return (words[i >> 6] >> (i & 63)) & 1;
+    }
+
+    void set(int i) {
+        words[i >> 6] |= (uint64_t)1 << (i & 63);
+    }
+
+    void reset(int i) {
+        words[i >> 6] &= ~((uint64_t)1 << (i & 63));
+    }
+
+    void assign(int i, bool value) {
+        if (value) {
+            set(i);
+        } else {
+            reset(i);
+        }
+    }
+
+    int count() const {
+        int total = 0;
+        for (uint64_t w : words) {
+            total += __builtin_popcountll(w);
+        }
+        return total;
+    }
+};
@@ -0,0 +1,87 @@
+#include <algorithm>
+#include <cstdlib>
+#include <vector>
+#include "struct.h"
+#include "choker.h"
+
+using namespace std;
+
+void UploadScheduler::init(int numtasks, int nr_slots) {
+    this->nr_slots = nr_slots;
+    unchoked.assign(numtasks, false);
+    nr_unchoked = 0;
+    interested.assign(numtasks, false);
+    last_received.assign(numtasks, 0);
+    optimistic = NOT_FOUND;
+    nr_rechokes = 0;
+    last_rechoke_ns = 0;
+}
+
+// poate fi servita o cerere de la "rank"? un slot liber se da imediat, fara sa astepte reevaluarea
+bool UploadScheduler::allow(int rank) {
+    interested[rank] = true;
+
+    if (unchoked[rank]) {
+        return true;
+    }
+    if (nr_unchoked < nr_slots) {
+        unchoked[rank] = true;
+        nr_unchoked++;
+        return true;
+    }
+    return false;
+}
+
+bool UploadScheduler::rechoke_due(uint64_t now_ns) const {
+    return now_ns - last_rechoke_ns >= (uint64_t)RECHOKE_INTERVAL_MS * 1000000;
+}
+
+// "received_from": cate chunk-uri am descarcat in total de la fiecare rank
+void UploadScheduler::rechoke(const vector<int>& received_from, uint64_t now_ns) {
+    vector<int> candidates;
+    vector<int> rate(unchoked.size(), 0);
+
+    for (int r = 0; r < (int)unchoked.size(); r++) {
+        rate[r] = received_from[r] - last_received[r];
+        if (interested[r]) {
+            candidates.push_back(r);
+        }
+    }
+
+    // la egalitate (ex: suntem seed si nu descarcam de la nimeni) ordinea e aleatoare
+    for (int i = (int)candidates.size() - 1; i > 0; i--) {
+        swap(candidates[i], candidates[rand() % (i + 1)]);
+    }
+    stable_sort(candidates.begin(), candidates.end(), [&rate](int a, int b) {
+        return rate[a] > rate[b];
+    });
+
+    /* daca sunt mai multi doritori decat sloturi, cei mai generosi primesc sloturile obisnuite
+    si unul ramane pentru deblocarea optimista */
+    int nr_regular = (int)candidates.size() <= nr_slots ? candidates.size() : nr_slots - 1;
+    unchoked.assign(unchoked.size(), false);
+    for (int i = 0; i < nr_regular; i++) {
+        unchoked[candidates[i]] = true;
+    }
+    nr_unchoked = nr_regular;
+
+    // deblocarea optimista se schimba doar o data la cateva reevaluari
+    bool keep = optimistic != NOT_FOUND && interested[optimistic] && !unchoked[optimistic]
+                && nr_rechokes % OPTIMISTIC_UNCHOKE_EVERY != 0;
+    if (!keep) {
+        optimistic = NOT_FOUND;
+        int nr_left = candidates.size() - nr_regular;
+        if (nr_left > 0) {
+            optimistic = candidates[nr_regular + rand() % nr_left];
+        }
+    }
+    if (optimistic != NOT_FOUND && nr_unchoked < nr_slots) {
+        unchoked[optimistic] = true;
+        nr_unchoked++;
+    }
+
+    interested.assign(interested.size(), false);
+    last_received = received_from;
+    last_rechoke_ns = now_ns;
+    nr_rechokes++;
+}
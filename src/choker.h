@@ -0,0 +1,26 @@
+#pragma once
+
+#include <stdint.h>
+#include <vector>
+#include "struct.h"
+
+/* planificatorul thread-ului de upload (tit-for-tat): doar "nr_slots" peeri sunt deblocati
+(unchoked) simultan; periodic ii pastram pe cei de la care am descarcat cel mai mult in ultima
+perioada, plus unul ales la intamplare (optimistic unchoke), ca peerii noi sa aiba o sansa.
+Cererile celorlalti primesc un raspuns "choked" imediat, ca sa caute alta sursa */
+class UploadScheduler {
+public:
+    int nr_slots;
+    std::vector<char> unchoked;     // indexat dupa rank
+    int nr_unchoked;
+    std::vector<char> interested;   // a cerut chunk-uri de la ultima reevaluare
+    std::vector<int> last_received; // cate chunk-uri primisem de la fiecare la ultima reevaluare
+    int optimistic;                 // rank-ul deblocat optimist (NOT_FOUND daca nu e)
+    int nr_rechokes;
+    uint64_t last_rechoke_ns;
+
+    void init(int numtasks, int nr_slots);
+    bool allow(int rank);
+    bool rechoke_due(uint64_t now_ns) const;
+    void rechoke(const std::vector<int>& received_from, uint64_t now_ns);
+};
@@ -0,0 +1,58 @@
+#include <vector>
+#include "struct.h"
+#include "digest.h"
+#include "chunk_store.h"
+
+using namespace std;
+
+bool identifier_equal::operator()(const identifier& a, const identifier& b) const {
+    return digest_equal(a, b);
+}
+
+void ChunkStore::map_file(int file_index, const vector<identifier>& ids) {
+    if (file_index >= (int)file_entries.size()) {
+        file_entries.resize(file_index + 1);
+    }
+    vector<int>& entries = file_entries[file_index];
+    entries.resize(ids.size());
+
+    for (int c = 0; c < (int)ids.size(); c++) {
+        auto it = index.find(ids[c]);
+        int entry;
+        if (it != index.end()) {
+            entry = it->second;
+        } else {
+            entry = held.size();
+            index.emplace(ids[c], entry);
+            held.push_back({NOT_FOUND, NOT_FOUND});
+            refs.emplace_back();
+        }
+        entries[c] = entry;
+        refs[entry].push_back({file_index, c});
+    }
+}
+
+int ChunkStore::entry_of(int file_index, int chunk_index) const {
+    return file_entries[file_index][chunk_index];
+}
+
+void ChunkStore::set_held(int file_index, int chunk_index) {
+    int entry = entry_of(file_index, chunk_index);
+    if (held[entry].file_index == NOT_FOUND) {
+        held[entry] = {file_index, chunk_index};
+    }
+}
+
+bool ChunkStore::find_held(int entry, chunk_ref& where) const {
+    where = held[entry];
+    return where.file_index != NOT_FOUND;
+}
+
+bool ChunkStore::find_held(const identifier& id, chunk_ref& where) const {
+    auto it = index.find(id);
+    return it != index.end() && find_held(it->second, where);
+}
+
+const vector<chunk_ref>& ChunkStore::uses(int entry) const {
+    return refs[entry];
+}
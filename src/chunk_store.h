@@ -0,0 +1,49 @@
+#pragma once
+
+#include <stdint.h>
+#include <cstring>
+#include <unordered_map>
+#include <vector>
+#include "struct.h"
+
+// un chunk al unui fisier local
+struct chunk_ref {
+    int file_index;
+    int chunk_index;
+};
+
+struct identifier_hash {
+    size_t operator()(const identifier& id) const {
+        // digest-ul e deja uniform, primii 8 octeti ajung
+        uint64_t h;
+        memcpy(&h, id.digest, sizeof(h));
+        return h;
+    }
+};
+
+struct identifier_equal {
+    bool operator()(const identifier& a, const identifier& b) const;
+};
+
+/* indexul chunk-urilor unui peer dupa continut (digest): fiecare fisier cunoscut isi mapeaza
+chunk-urile pe intrari, iar acelasi digest din fisiere diferite (sau de mai multe ori in acelasi
+fisier) e o singura intrare. O intrare tine prima copie detinuta, din care se pot completa local
+celelalte aparitii si se pot servi cereri venite pentru oricare dintre fisiere */
+class ChunkStore {
+public:
+    // o singura data per fisier, cand ii stim hash-urile
+    void map_file(int file_index, const std::vector<identifier>& ids);
+    int entry_of(int file_index, int chunk_index) const;
+    // prima copie detinuta devine sursa intrarii
+    void set_held(int file_index, int chunk_index);
+    bool find_held(int entry, chunk_ref& where) const;
+    bool find_held(const identifier& id, chunk_ref& where) const;
+    // toate locurile in care apare continutul intrarii
+    const std::vector<chunk_ref>& uses(int entry) const;
+
+private:
+    std::unordered_map<identifier, int, identifier_hash, identifier_equal> index;
+    std::vector<std::vector<int>> file_entries; // indexat dupa fisier, apoi dupa chunk
+    std::vector<chunk_ref> held;                // NOT_FOUND daca nu detinem continutul
+    std::vector<std::vector<chunk_ref>> refs;
+};
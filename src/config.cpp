@@ -0,0 +1,108 @@
+#include <iostream>
+#include <cstring>
+#include <cstdlib>
+#include "struct.h"
+#include "config.h"
+
+using namespace std;
+
+// valorile implicite vin din struct.h
+sim_config config = {
+    NR_TRACKERS,
+    DOWNLOAD_WINDOW,
+    PARALLEL_DOWNLOADS,
+    UPLOAD_RECV_SLOTS,
+    UPLOAD_SLOTS,
+    CHUNK_PAYLOAD_SIZE,
+    ENDGAME_THRESHOLD,
+    1,
+    "adaptive",
+    "auto",
+    1,
+    nullptr,
+};
+
+struct int_option {
+    const char* name;
+    int* value;
+    int min_value;
+};
+
+static int_option int_options[] = {
+    {"--trackers", &config.nr_trackers, 1},
+    {"--window", &config.download_window, 1},
+    {"--parallel-files", &config.parallel_downloads, 1},
+    {"--upload-recvs", &config.upload_recv_slots, 1},
+    {"--upload-slots", &config.upload_slots, 1},
+    {"--chunk-size", &config.chunk_size, 0},
+    {"--endgame", &config.endgame_threshold, 0},
+    {"--push", &config.swarm_push, 0},
+    {"--comm-thread", &config.comm_thread, 0},
+};
+
+// valorile acceptate de o optiune text, terminate cu nullptr
+static const char* selector_values[] = {"adaptive", "legacy", nullptr};
+static const char* transport_values[] = {"auto", "mpi", "shm", nullptr};
+
+struct string_option {
+    const char* name;
+    const char** value;
+    const char** choices; // nullptr = orice valoare
+};
+
+static string_option string_options[] = {
+    {"--selector", &config.selector, selector_values},
+    {"--transport", &config.transport, transport_values},
+    {"--report", &config.report_path, nullptr},
+};
+
+static bool valid_choice(const char** choices, const char* value) {
+    if (choices == nullptr) {
+        return true;
+    }
+    for (int i = 0; choices[i] != nullptr; i++) {
+        if (strcmp(choices[i], value) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void parse_config(int argc, char* argv[]) {
+    int nr_options = sizeof(int_options) / sizeof(int_options[0]);
+    int nr_string_options = sizeof(string_options) / sizeof(string_options[0]);
+
+    for (int i = 1; i < argc; i++) {
+        bool known = false;
+
+        for (int j = 0; j < nr_options; j++) {
+            if (strcmp(argv[i], int_options[j].name) != 0 || i + 1 >= argc) {
+                continue;
+            }
+
+            int val = atoi(argv[++i]);
+            *(int_options[j].value) = val < int_options[j].min_value ? int_options[j].min_value : val;
+            known = true;
+            break;
+        }
+
+        for (int j = 0; j < nr_string_options && !known; j++) {
+            if (strcmp(argv[i], string_options[j].name) != 0 || i + 1 >= argc) {
+                continue;
+            }
+
+            // o valoare necunoscuta e ignorata, ramane cea implicita
+            if (valid_choice(string_options[j].choices, argv[i + 1])) {
+                *(string_options[j].value) = argv[i + 1];
+            } else {
+                cerr << "Invalid value for " << argv[i] << ": " << argv[i + 1] << endl;
+            }
+            i++;
+            known = true;
+        }
+
+        if (!known) {
+            cerr << "Unknown option: " << argv[i] << endl;
+        }
+    }
+}
@@ -0,0 +1,21 @@
+#pragma once
+
+// parametri configurabili din linia de comanda (ex: mpirun -np 4 ./tema2 --window 16)
+struct sim_config {
+    int nr_trackers;        // cate rank-uri (de la 0) impart intre ele swarm-urile
+    int download_window;    // cate cereri de chunk pot fi in curs simultan
+    int parallel_downloads; // cate fisiere se descarca simultan
+    int upload_recv_slots;  // cate cereri de chunk poate primi simultan thread-ul de upload
+    int upload_slots;       // cati peeri deserveste simultan thread-ul de upload
+    int chunk_size;         // octeti de payload per chunk (0 = se transfera doar hash-ul)
+    int endgame_threshold;  // sub cate chunk-uri ramase se cer chunk-urile de la mai multe surse
+    int swarm_push;         // 1 = tracker-ul trimite schimbarile swarm-urilor, 0 = peerii le cer periodic
+    const char* selector;   // alegerea sursei unui chunk: "adaptive" sau "legacy"
+    const char* transport;  // canalul cererilor de chunk-uri: "auto", "mpi" sau "shm" (vezi transport.h)
+    int comm_thread;        // 1 = doar thread-ul principal apeleaza MPI (vezi progress.h), 0 = toate
+    const char* report_path; // unde scrie tracker-ul raportul cu statistici (.csv sau json), nullptr = deloc
+};
+
+extern sim_config config;
+
+void parse_config(int argc, char* argv[]);
@@ -0,0 +1,33 @@
+#include <iostream>
+#include <string>
+#include "struct.h"
+#include "loader.h"
+
+using namespace std;
+
+// converteste fisierele de input text (in<rank>.txt) in formatul binar (in<rank>.bin)
+int main(int argc, char* argv[]) {
+    if (argc < 2) {
+        cerr << "Usage: " << argv[0] << " in1.txt [in2.txt ...]" << endl;
+        return 1;
+    }
+
+    int nr_errors = 0;
+    for (int i = 1; i < argc; i++) {
+        string src = argv[i];
+        string dst = src.substr(0, src.rfind('.')) + ".bin";
+        peer_input in;
+
+        if (!load_text_input(src.c_str(), in)) {
+            cerr << "Error reading input file: " << src << endl;
+            nr_errors++;
+            continue;
+        }
+        if (!save_binary_input(dst.c_str(), in)) {
+            cerr << "Error writing binary file: " << dst << endl;
+            nr_errors++;
+        }
+    }
+
+    return nr_errors > 0 ? 1 : 0;
+}
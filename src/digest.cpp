@@ -0,0 +1,111 @@
+#include <stdint.h>
+#include <cstring>
+#include "struct.h"
+#include "digest.h"
+
+#if defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+// varianta AVX2 se compileaza separat (atributul target) si se alege la rulare
+#if defined(__SSE2__) && defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define DIGEST_AVX2 1
+#endif
+
+static_assert(sizeof(identifier) == 16, "kernel-urile SIMD presupun digest-uri de 16 octeti");
+
+typedef int (*verify_kernel)(const identifier*, const identifier*, int, char*);
+
+[[maybe_unused]] static int verify_scalar(const identifier* got, const identifier* expected, int n, char* ok) {
+    int nr_equal = 0;
+
+    for (int i = 0; i < n; i++) {
+        uint64_t a[2], b[2];
+        memcpy(a, got[i].digest, sizeof(a));
+        memcpy(b, expected[i].digest, sizeof(b));
+
+        ok[i] = ((a[0] ^ b[0]) | (a[1] ^ b[1])) == 0;
+        nr_equal += ok[i];
+    }
+    return nr_equal;
+}
+
+#if defined(__SSE2__)
+static inline bool equal_sse2(const identifier* a, const identifier* b) {
+    __m128i x = _mm_loadu_si128((const __m128i*)a->digest);
+    __m128i y = _mm_loadu_si128((const __m128i*)b->digest);
+    return _mm_movemask_epi8(_mm_cmpeq_epi8(x, y)) == 0xffff;
+}
+
+static int verify_sse2(const identifier* got, const identifier* expected, int n, char* ok) {
+    int nr_equal = 0;
+
+    for (int i = 0; i < n; i++) {
+        ok[i] = equal_sse2(&got[i], &expected[i]);
+        nr_equal += ok[i];
+    }
+    return nr_equal;
+}
+
+#if defined(DIGEST_AVX2)
+// compilata pentru AVX2 chiar daca restul programului nu e; apelata doar daca procesorul il are
+__attribute__((target("avx2")))
+static int verify_avx2(const identifier* got, const identifier* expected, int n, char* ok) {
+    int nr_equal = 0;
+    int i = 0;
+
+    // doua digest-uri consecutive intr-un registru de 256 de biti, cate o jumatate de masca fiecare
+    for (; i + 2 <= n; i += 2) {
+        __m256i x = _mm256_loadu_si256((const __m256i*)got[i].digest);
+        __m256i y = _mm256_loadu_si256((const __m256i*)expected[i].digest);
+        uint32_t mask = _mm256_movemask_epi8(_mm256_cmpeq_epi8(x, y));
+
+        ok[i] = (mask & 0xffff) == 0xffff;
+        ok[i + 1] = (mask >> 16) == 0xffff;
+        nr_equal += ok[i] + ok[i + 1];
+    }
+
+    for (; i < n; i++) {
+        ok[i] = equal_sse2(&got[i], &expected[i]);
+        nr_equal += ok[i];
+    }
+    return nr_equal;
+}
+#endif
+#endif
+
+static verify_kernel pick_kernel(const char** name) {
+#if defined(__SSE2__)
+#if defined(DIGEST_AVX2)
+    if (__builtin_cpu_supports("avx2")) {
+        *name = "avx2";
+        return verify_avx2;
+    }
+#endif
+    *name = "sse2";
+    return verify_sse2;
+#else
+    *name = "scalar";
+    return verify_scalar;
+#endif
+}
+
+static const char* kernel_name;
+static const verify_kernel kernel = pick_kernel(&kernel_name);
+
+bool digest_equal(const identifier& a, const identifier& b) {
+#if defined(__SSE2__)
+    return equal_sse2(&a, &b);
+#else
+    char ok;
+    return verify_scalar(&a, &b, 1, &ok) == 1;
+#endif
+}
+
+int verify_digests(const identifier* got, const identifier* expected, int n, char* ok) {
+    return kernel(got, expected, n, ok);
+}
+
+const char* digest_kernel_name() {
+    return kernel_name;
+}
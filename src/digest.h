@@ -0,0 +1,14 @@
+#pragma once
+
+#include "struct.h"
+
+/* compararea digest-urilor (identifier, DIGEST_SIZE octeti) cu SIMD: AVX2 (doua perechi pe
+instructiune) daca procesorul il are, altfel SSE2, altfel scalar (doua comparatii pe 64 de biti) */
+
+bool digest_equal(const identifier& a, const identifier& b);
+
+// ok[i] = 1 daca got[i] == expected[i]; intoarce cate perechi sunt egale
+int verify_digests(const identifier* got, const identifier* expected, int n, char* ok);
+
+// varianta aleasa la pornire ("avx2", "sse2" sau "scalar"), pentru raport
+const char* digest_kernel_name();
@@ -0,0 +1,233 @@
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cmath>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include "struct.h"
+#include "loader.h"
+
+using namespace std;
+
+/* genereaza fisierele de input pentru o simulare de orice dimensiune, in directorul dat:
+    make gen && ./gen_workload <dir> [--ranks N] [--trackers T] [--files F] [--chunks C]
+        [--seed-ratio R] [--owned K] [--wanted W] [--zipf S] [--shared P] [--seed X] [--binary 1]
+
+O fractiune R din peeri (cel putin unul) sunt seed-uri: au cate K fisiere intregi si nu vor
+nimic. Ceilalti vor cate W fisiere. Fisierele alese (detinute sau dorite) urmeaza o distributie
+Zipf cu exponentul S (fisierul i are popularitatea 1 / (i + 1)^S, S = 0 e uniform), dar
+fiecare fisier are cel putin un seed. O fractiune P din chunk-urile fiecarui fisier (dupa primul)
+repeta continutul unui chunk aleator dintr-un fisier anterior, ca in fisierele care au parti
+comune. Rank-urile 0 .. T - 1 sunt tracker-e si nu au input. */
+
+struct workload_config {
+    int nr_ranks = 16;
+    int nr_trackers = NR_TRACKERS;
+    int nr_files = 8;
+    int nr_chunks = 100;
+    double seed_ratio = 0.25;
+    int nr_owned = 2;
+    int nr_wanted = 2;
+    double zipf = 1.0;
+    double shared = 0;
+    int seed = 1;
+    int binary = 0;
+};
+
+struct int_arg {
+    const char* name;
+    int* value;
+    int min_value;
+};
+
+struct double_arg {
+    const char* name;
+    double* value;
+};
+
+static bool parse_args(int argc, char* argv[], workload_config& wl) {
+    int_arg int_args[] = {
+        {"--ranks", &wl.nr_ranks, 2},
+        {"--trackers", &wl.nr_trackers, 1},
+        {"--files", &wl.nr_files, 1},
+        {"--chunks", &wl.nr_chunks, 1},
+        {"--owned", &wl.nr_owned, 1},
+        {"--wanted", &wl.nr_wanted, 0},
+        {"--seed", &wl.seed, 0},
+        {"--binary", &wl.binary, 0},
+    };
+    double_arg double_args[] = {
+        {"--seed-ratio", &wl.seed_ratio},
+        {"--zipf", &wl.zipf},
+        {"--shared", &wl.shared},
+    };
+
+    for (int i = 2; i < argc; i++) {
+        bool known = false;
+
+        for (int_arg& a : int_args) {
+            if (strcmp(argv[i], a.name) == 0 && i + 1 < argc) {
+                *(a.value) = max(atoi(argv[++i]), a.min_value);
+                known = true;
+                break;
+            }
+        }
+        for (double_arg& a : double_args) {
+            if (!known && strcmp(argv[i], a.name) == 0 && i + 1 < argc) {
+                *(a.value) = max(atof(argv[++i]), 0.0);
+                known = true;
+                break;
+            }
+        }
+
+        if (!known) {
+            cerr << "Unknown option: " << argv[i] << endl;
+            return false;
+        }
+    }
+
+    if (wl.nr_trackers >= wl.nr_ranks) {
+        cerr << "Need at least one client besides the " << wl.nr_trackers << " trackers" << endl;
+        return false;
+    }
+    wl.nr_owned = min(wl.nr_owned, wl.nr_files);
+    wl.nr_wanted = min(wl.nr_wanted, wl.nr_files);
+    wl.shared = min(wl.shared, 1.0);
+    return true;
+}
+
+// "count" fisiere distincte, alese dupa popularitate (fara repetitie)
+static vector<int> pick_files(const vector<double>& popularity, int count, mt19937& gen) {
+    vector<double> weights = popularity;
+    vector<int> picked;
+
+    while ((int)picked.size() < count) {
+        discrete_distribution<int> dist(weights.begin(), weights.end());
+        int f = dist(gen);
+        picked.push_back(f);
+        weights[f] = 0;
+    }
+    return picked;
+}
+
+static bool write_text_input(const char* path, const peer_input& in) {
+    FILE* out = fopen(path, "w");
+    if (out == nullptr) {
+        return false;
+    }
+
+    char hex[HASH_SIZE + 1];
+    hex[HASH_SIZE] = '\0';
+
+    fprintf(out, "%d\n", (int)in.owned.size());
+    for (const file_data& f : in.owned) {
+        fprintf(out, "%s %d\n", f.filename, f.nr_total_chunks);
+        for (const identifier& id : f.identifiers) {
+            identifier_to_hex(id, hex);
+            fprintf(out, "%s\n", hex);
+        }
+    }
+
+    fprintf(out, "%d\n", (int)in.wanted.size());
+    for (const file_data& f : in.wanted) {
+        fprintf(out, "%s\n", f.filename);
+    }
+
+    return fclose(out) == 0;
+}
+
+int main(int argc, char* argv[]) {
+    workload_config wl;
+    if (argc < 2 || !parse_args(argc, argv, wl)) {
+        cerr << "Usage: " << argv[0] << " <dir> [--ranks N] [--trackers T] [--files F] [--chunks C]"
+             << " [--seed-ratio R] [--owned K] [--wanted W] [--zipf S] [--shared P] [--seed X] [--binary 1]" << endl;
+        return 1;
+    }
+
+    mt19937 gen(wl.seed);
+    mt19937_64 hash_gen(wl.seed);
+
+    // continutul fisierelor: aceleasi hash-uri la toti detinatorii
+    vector<file_data> files(wl.nr_files);
+    vector<double> popularity(wl.nr_files);
+    for (int i = 0; i < wl.nr_files; i++) {
+        memset(files[i].filename, 0, MAX_FILENAME);
+        snprintf(files[i].filename, MAX_FILENAME, "file%d", i + 1);
+        files[i].nr_total_chunks = wl.nr_chunks;
+        files[i].identifiers.resize(wl.nr_chunks);
+        for (identifier& id : files[i].identifiers) {
+            for (int b = 0; b < DIGEST_SIZE; b += 8) {
+                uint64_t x = hash_gen();
+                memcpy(id.digest + b, &x, 8);
+            }
+        }
+        popularity[i] = 1.0 / pow(i + 1, wl.zipf);
+    }
+
+    // chunk-urile comune se aleg separat, ca fisierele sa ramana aceleasi pentru --shared 0
+    mt19937 shared_gen(wl.seed + 1);
+    uniform_real_distribution<double> coin(0, 1);
+    for (int i = 1; i < wl.nr_files && wl.shared > 0; i++) {
+        for (identifier& id : files[i].identifiers) {
+            if (coin(shared_gen) < wl.shared) {
+                const file_data& other = files[shared_gen() % i];
+                id = other.identifiers[shared_gen() % other.nr_total_chunks];
+            }
+        }
+    }
+
+    // primii peeri (dupa amestecare) sunt seed-urile
+    int nr_peers = wl.nr_ranks - wl.nr_trackers;
+    int nr_seeders = max(1, (int)lround(wl.seed_ratio * nr_peers));
+    nr_seeders = min(nr_seeders, nr_peers);
+    vector<int> peers(nr_peers);
+    for (int p = 0; p < nr_peers; p++) {
+        peers[p] = wl.nr_trackers + p;
+    }
+    shuffle(peers.begin(), peers.end(), gen);
+
+    vector<peer_input> inputs(wl.nr_ranks);
+    vector<char> has_seed(wl.nr_files, false);
+    for (int s = 0; s < nr_seeders; s++) {
+        vector<int> owned = pick_files(popularity, wl.nr_owned, gen);
+        for (int f : owned) {
+            inputs[peers[s]].owned.push_back(files[f]);
+            has_seed[f] = true;
+        }
+    }
+
+    // fisierele ramase fara seed sunt date, pe rand, seed-urilor
+    for (int f = 0, s = 0; f < wl.nr_files; f++) {
+        if (!has_seed[f]) {
+            inputs[peers[s++ % nr_seeders]].owned.push_back(files[f]);
+        }
+    }
+
+    // restul peerilor doar descarca
+    for (int p = nr_seeders; p < nr_peers; p++) {
+        vector<int> wanted = pick_files(popularity, wl.nr_wanted, gen);
+        for (int f : wanted) {
+            file_data w;
+            memcpy(w.filename, files[f].filename, MAX_FILENAME);
+            w.nr_total_chunks = 0;
+            inputs[peers[p]].wanted.push_back(w);
+        }
+    }
+
+    int nr_errors = 0;
+    for (int r = wl.nr_trackers; r < wl.nr_ranks; r++) {
+        string path = string(argv[1]) + "/in" + to_string(r) + (wl.binary ? ".bin" : ".txt");
+        bool ok = wl.binary ? save_binary_input(path.c_str(), inputs[r]) : write_text_input(path.c_str(), inputs[r]);
+        if (!ok) {
+            cerr << "Error writing input file: " << path << endl;
+            nr_errors++;
+        }
+    }
+
+    printf("ranks=%d trackers=%d peers=%d seeders=%d files=%d chunks=%d\n", wl.nr_ranks, wl.nr_trackers,
+           nr_peers, nr_seeders, wl.nr_files, wl.nr_chunks);
+    return nr_errors > 0 ? 1 : 0;
+}
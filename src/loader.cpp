@@ -0,0 +1,226 @@
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+#include "struct.h"
+#include "loader.h"
+
+using namespace std;
+
+// fisier de input mapat in memorie (doar citire)
+struct mapped_file {
+    const char* data = nullptr;
+    size_t size = 0;
+
+    bool open(const char* path) {
+        int fd = ::open(path, O_RDONLY);
+        if (fd < 0) {
+            return false;
+        }
+
+        struct stat st;
+        if (fstat(fd, &st) != 0) {
+            close(fd);
+            return false;
+        }
+
+        size = st.st_size;
+        if (size > 0) {
+            void* p = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (p == MAP_FAILED) {
+                close(fd);
+                return false;
+            }
+            data = static_cast<const char*>(p);
+            madvise(p, size, MADV_SEQUENTIAL);
+        }
+
+        close(fd);
+        return true;
+    }
+
+    ~mapped_file() {
+        if (data != nullptr) {
+            munmap((void*)data, size);
+        }
+    }
+};
+
+// parcurge textul o singura data; la orice eroare "ok" devine false si restul citirilor esueaza
+struct text_scanner {
+    const char* p;
+    const char* end;
+    bool ok = true;
+
+    void skip_space() {
+        while (p < end && (*p == ' ' || *p == '\n' || *p == '\r' || *p == '\t')) {
+            p++;
+        }
+    }
+
+    // intoarce inceputul cuvantului urmator si ii pune lungimea in "len"
+    const char* word(int& len) {
+        skip_space();
+        const char* start = p;
+        while (p < end && *p != ' ' && *p != '\n' && *p != '\r' && *p != '\t') {
+            p++;
+        }
+        len = p - start;
+        ok = ok && len > 0;
+        return start;
+    }
+
+    int read_int() {
+        int len;
+        const char* w = word(len);
+        int value = 0;
+        for (int i = 0; i < len && ok; i++) {
+            ok = w[i] >= '0' && w[i] <= '9';
+            value = value * 10 + (w[i] - '0');
+        }
+        return value;
+    }
+
+    void read_name(char* name) {
+        int len;
+        const char* w = word(len);
+        ok = ok && len < MAX_FILENAME;
+        if (ok) {
+            memset(name, 0, MAX_FILENAME);
+            memcpy(name, w, len);
+        }
+    }
+
+    void read_identifier(identifier& id) {
+        int len;
+        const char* w = word(len);
+        ok = ok && len == HASH_SIZE && hex_to_identifier(w, id);
+    }
+};
+
+bool load_text_input(const char* path, peer_input& in) {
+    mapped_file file;
+    if (!file.open(path)) {
+        return false;
+    }
+
+    text_scanner sc = {file.data, file.data + file.size};
+
+    int nr_owned = sc.read_int();
+    in.owned.resize(sc.ok ? nr_owned : 0);
+    for (int i = 0; i < nr_owned && sc.ok; i++) {
+        file_data& f = in.owned[i];
+        sc.read_name(f.filename);
+        f.nr_total_chunks = sc.read_int();
+
+        f.identifiers.resize(sc.ok ? f.nr_total_chunks : 0);
+        for (int j = 0; j < f.nr_total_chunks && sc.ok; j++) {
+            sc.read_identifier(f.identifiers[j]);
+        }
+    }
+
+    int nr_wanted = sc.read_int();
+    in.wanted.resize(sc.ok ? nr_wanted : 0);
+    for (int i = 0; i < nr_wanted && sc.ok; i++) {
+        sc.read_name(in.wanted[i].filename);
+        in.wanted[i].nr_total_chunks = 0;
+    }
+
+    return sc.ok;
+}
+
+bool load_binary_input(const char* path, peer_input& in) {
+    mapped_file file;
+    if (!file.open(path)) {
+        return false;
+    }
+
+    const char* p = file.data;
+    const char* end = file.data + file.size;
+    uint32_t magic, version;
+    int count;
+
+    // fiecare bloc se copiaza direct, verificand doar ca nu depaseste fisierul
+    auto take = [&](void* dst, size_t len) {
+        if ((size_t)(end - p) < len) {
+            return false;
+        }
+        memcpy(dst, p, len);
+        p += len;
+        return true;
+    };
+
+    if (!take(&magic, sizeof(magic)) || !take(&version, sizeof(version)) || !take(&count, sizeof(int))
+        || magic != BINARY_INPUT_MAGIC || version != BINARY_INPUT_VERSION || count < 0) {
+        return false;
+    }
+
+    in.owned.resize(count);
+    for (file_data& f : in.owned) {
+        file_header header;
+        if (!take(&header, sizeof(file_header)) || header.nr_total_chunks < 0) {
+            return false;
+        }
+
+        memcpy(f.filename, header.filename, MAX_FILENAME);
+        f.filename[MAX_FILENAME - 1] = '\0';
+        f.nr_total_chunks = header.nr_total_chunks;
+        f.identifiers.resize(header.nr_total_chunks);
+        if (!take(f.identifiers.data(), header.nr_total_chunks * sizeof(identifier))) {
+            return false;
+        }
+    }
+
+    if (!take(&count, sizeof(int)) || count < 0) {
+        return false;
+    }
+
+    in.wanted.resize(count);
+    for (file_data& f : in.wanted) {
+        if (!take(f.filename, MAX_FILENAME)) {
+            return false;
+        }
+        f.filename[MAX_FILENAME - 1] = '\0';
+        f.nr_total_chunks = 0;
+    }
+
+    return true;
+}
+
+bool save_binary_input(const char* path, const peer_input& in) {
+    FILE* out = fopen(path, "wb");
+    if (out == nullptr) {
+        return false;
+    }
+
+    uint32_t magic = BINARY_INPUT_MAGIC;
+    uint32_t version = BINARY_INPUT_VERSION;
+    int count = in.owned.size();
+    fwrite(&magic, sizeof(magic), 1, out);
+    fwrite(&version, sizeof(version), 1, out);
+    fwrite(&count, sizeof(int), 1, out);
+
+    for (const file_data& f : in.owned) {
+        file_header header;
+        memset(&header, 0, sizeof(file_header));
+        memcpy(header.filename, f.filename, MAX_FILENAME);
+        header.nr_total_chunks = f.nr_total_chunks;
+
+        fwrite(&header, sizeof(file_header), 1, out);
+        fwrite(f.identifiers.data(), sizeof(identifier), f.nr_total_chunks, out);
+    }
+
+    count = in.wanted.size();
+    fwrite(&count, sizeof(int), 1, out);
+    for (const file_data& f : in.wanted) {
+        char name[MAX_FILENAME];
+        memset(name, 0, MAX_FILENAME);
+        strncpy(name, f.filename, MAX_FILENAME - 1);
+        fwrite(name, MAX_FILENAME, 1, out);
+    }
+
+    return fclose(out) == 0;
+}
@@ -0,0 +1,23 @@
+#pragma once
+
+#include <stdint.h>
+#include <vector>
+#include "struct.h"
+
+// ce citeste un peer la pornire: fisierele detinute (cu identificatori) si cele dorite (doar numele)
+struct peer_input {
+    std::vector<file_data> owned;
+    std::vector<file_data> wanted;
+};
+
+/* formatul binar (generat de convert_input din in<rank>.txt), citit aproape fara parsare:
+[uint32 magic][uint32 version][int nr_owned]
+[file_header][identifier x nr_total_chunks] pentru fiecare fisier detinut
+[int nr_wanted][char filename[MAX_FILENAME] x nr_wanted] */
+#define BINARY_INPUT_MAGIC   0x4d495354 // "TSIM"
+#define BINARY_INPUT_VERSION 1
+
+// fisierul text, mapat in memorie si parcurs o singura data (hash-urile hex devin digest-uri)
+bool load_text_input(const char* path, peer_input& in);
+bool load_binary_input(const char* path, peer_input& in);
+bool save_binary_input(const char* path, const peer_input& in);
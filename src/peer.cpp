@@ -1,10 +1,19 @@
 #include <mpi.h>
 #include <pthread.h>
 #include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 #include <iostream>
-#include <fstream>
+#include <cstring>
+#include <vector>
+#include <algorithm>
 #include "struct.h"
+#include "config.h"
 #include "peer.h"
+#include "stats.h"
+#include "loader.h"
+#include "digest.h"
 
 using namespace std;
 
@@ -13,289 +22,1331 @@ PeerManager::PeerManager(int rank, int numtasks) : rank(rank), numtasks(numtasks
     nr_owned_files = 0;
     nr_files = 0;
     read_input_file();
+    known_seeds.assign(nr_files, vector<int>());
 
-    for (int i = 0; i < MAX_CLIENTS; i++) {
-        used_peer[i] = 0;
-    }
+    selector.init(numtasks, strcmp(config.selector, "legacy") != 0);
+    choked_until.assign(numtasks, 0);
+    received_from.assign(numtasks, 0);
+    pthread_mutex_init(&files_lock, nullptr);
+
+    // fara MPI_THREAD_MULTIPLE, operatiile MPI ale thread-urilor trec prin thread-ul principal
+    engine = config.comm_thread ? new ProgressEngine() : nullptr;
+    transport = funnel_transport(engine, create_transport(config.transport, config.chunk_size));
+    control = funnel_transport(engine, new MpiTransport(MPI_COMM_WORLD, false));
+
+    // peerii nu fac parte din comunicatorul tracker-elor, dar split-ul e colectiv
+    MPI_Comm tracker_comm;
+    MPI_Comm_split(MPI_COMM_WORLD, MPI_UNDEFINED, rank, &tracker_comm);
     srand(time(nullptr));
+}
 
-    DEBUG_NR_HELPS = 0;
+PeerManager::~PeerManager() {
+    for (int i = 0; i < nr_files; i++) {
+        free_payload(i);
+    }
+    pthread_mutex_destroy(&files_lock);
+    delete transport;
+    delete control;
+    delete engine;
 }
 
-// citim datele din fisierul de input
+/* citim datele din fisierul de input: in<rank>.bin daca a fost generat cu convert_input,
+altfel in<rank>.txt, mapat in memorie si parcurs o singura data (vezi loader.cpp) */
 void PeerManager::read_input_file() {
     char input_file_name[MAX_FILENAME];
-    sprintf(input_file_name, "in%d.txt", rank);
+    peer_input in;
+    bool loaded;
 
-    ifstream fin(input_file_name);
-    if (!fin.is_open()) {
-        cerr << "[Peer " << rank << "] Error opening input file: " << input_file_name << endl;
+    sprintf(input_file_name, "in%d.bin", rank);
+    if (access(input_file_name, R_OK) == 0) {
+        loaded = load_binary_input(input_file_name, in);
+    } else {
+        sprintf(input_file_name, "in%d.txt", rank);
+        loaded = load_text_input(input_file_name, in);
+    }
+
+    if (!loaded) {
+        cerr << "[Peer " << rank << "] Error reading input file: " << input_file_name << endl;
         exit(-1);
     }
-    
-    // citim datele despre fisierele detinute
-    fin >> nr_owned_files;
-    for (int i = 0; i < nr_owned_files; i++) {
-        file_data& file = files[i];
-        fin >> file.filename; 
-        fin >> file.nr_total_chunks;
-        nr_owned_chunks[i] = file.nr_total_chunks;
 
-        // citim hash-urile chunk-urilor
-        for (int j = 0; j < file.nr_total_chunks; j++) {
-            fin >> file.identifiers[j].hash;
+    // fisierele detinute sunt primele, urmate de cele dorite (doar numele)
+    nr_owned_files = in.owned.size();
+    nr_files = nr_owned_files + in.wanted.size();
+    files.swap(in.owned);
+    files.insert(files.end(), in.wanted.begin(), in.wanted.end());
+
+    nr_owned_chunks.resize(nr_files);
+    chunk_state.resize(nr_files);
+    for (int i = 0; i < nr_files; i++) {
+        nr_owned_chunks[i] = files[i].nr_total_chunks;
+        if (i < nr_owned_files) {
+            chunk_state[i].assign(files[i].nr_total_chunks, CHUNK_OWNED);
         }
     }
 
-    // citim fisierele dorite (doar numele)
-    int nr_files_to_download;
-    fin >> nr_files_to_download;
-    nr_files = nr_files_to_download + nr_owned_files;
+    // continutul fisierelor detinute poate completa local chunk-uri ale celor dorite
+    for (int i = 0; i < nr_owned_files; i++) {
+        store.map_file(i, files[i].identifiers);
+        for (int c = 0; c < files[i].nr_total_chunks; c++) {
+            store.set_held(i, c);
+        }
+    }
 
-    for (int i = nr_owned_files; i < nr_files; i++) {
-        file_data& file = files[i];
-        fin >> file.filename;
-        file.nr_total_chunks = 0;
-        nr_owned_chunks[i] = 0;
+    // in modul cu payload fisierele detinute primesc si continut
+    payloads.assign(nr_files, nullptr);
+    for (int i = 0; i < nr_owned_files && config.chunk_size > 0; i++) {
+        generate_payload(i);
+    }
+}
+
+/* buffer-ul cu continutul fisierului, alocat cu MPI_Alloc_mem ca transferurile sa se faca
+direct din/in el (fara copii intermediare); cu --comm-thread e alocat si din thread-ul de
+download, care nu apeleaza MPI, deci vine din posix_memalign */
+void PeerManager::alloc_payload(int file_index) {
+    MPI_Aint size = (MPI_Aint)files[file_index].nr_total_chunks * config.chunk_size;
+    if (!config.comm_thread) {
+        MPI_Alloc_mem(size > 0 ? size : 1, MPI_INFO_NULL, &payloads[file_index]);
+        return;
     }
 
-    fin.close();
+    void* data;
+    if (posix_memalign(&data, 64, size > 0 ? size : 1) != 0) {
+        cerr << "[Peer " << rank << "] Error allocating payload of " << size << " bytes" << endl;
+        exit(-1);
+    }
+    payloads[file_index] = static_cast<char*>(data);
 }
 
-void PeerManager::send_my_nr_files() {
-    MPI_Send(&nr_owned_files, 1, MPI_INT, TRACKER_RANK, MSG_INIT_NR_FILES, MPI_COMM_WORLD);
+void PeerManager::free_payload(int file_index) {
+    if (payloads[file_index] == nullptr) {
+        return;
+    }
+    if (config.comm_thread) {
+        free(payloads[file_index]);
+    } else {
+        MPI_Free_mem(payloads[file_index]);
+    }
+    payloads[file_index] = nullptr;
+}
+
+char* PeerManager::chunk_payload(int file_index, int chunk_index) {
+    return payloads[file_index] + (size_t)chunk_index * config.chunk_size;
+}
+
+// continutul unui chunk, determinist din hash-ul lui: FNV-1a peste hash da starea initiala a unui xorshift64
+static void fill_payload(const identifier& id, char* data) {
+    uint64_t x = 14695981039346656037ull;
+    for (int i = 0; i < DIGEST_SIZE; i++) {
+        x = (x ^ id.digest[i]) * 1099511628211ull;
+    }
+
+    for (int off = 0; off < config.chunk_size; off += sizeof(uint64_t)) {
+        x ^= x << 13;
+        x ^= x >> 7;
+        x ^= x << 17;
+        memcpy(data + off, &x, min((int)sizeof(uint64_t), config.chunk_size - off));
+    }
+}
+
+/* nu avem continutul real al fisierelor, asa ca il generam determinist din hash-ul fiecarui
+chunk (toate seed-urile unui fisier au astfel aceleasi date) si ii calculam SHA-256-ul,
+trimis tracker-ului odata cu metadatele */
+void PeerManager::generate_payload(int file_index) {
+    file_data& file = files[file_index];
+    alloc_payload(file_index);
+    file.payload_digests.resize(file.nr_total_chunks);
+
+    for (int c = 0; c < file.nr_total_chunks; c++) {
+        char* data = chunk_payload(file_index, c);
+        fill_payload(file.identifiers[c], data);
+        sha256(data, config.chunk_size, file.payload_digests[c]);
+    }
 }
 
+// trimitem tracker-ului principal metadatele fisierelor detinute (MPI_Gather + MPI_Gatherv)
 void PeerManager::send_own_files_data() {
+    vector<char> buf;
     for (int i = 0; i < nr_owned_files; i++) {
-        file_data* file = &(files[i]);
-        MPI_Send(file, sizeof(file_data), MPI_BYTE, TRACKER_RANK, MSG_INIT_FILES, MPI_COMM_WORLD);
+        pack_file_data(files[i], buf);
     }
+
+    int len = buf.size();
+    MPI_Gather(&len, 1, MPI_INT, nullptr, 0, MPI_INT, TRACKER_RANK, MPI_COMM_WORLD);
+    MPI_Gatherv(buf.data(), len, MPI_BYTE, nullptr, nullptr, nullptr, MPI_BYTE, TRACKER_RANK, MPI_COMM_WORLD);
 }
 
-// salvam hash-urile detinute in fisierul de output
-void PeerManager::save_output_file(int index) {
+// primim de la tracker id-urile fisierelor (MPI_Bcast), folosite in loc de nume in toate mesajele
+void PeerManager::receive_file_ids() {
+    int nr_ids;
+    MPI_Bcast(&nr_ids, 1, MPI_INT, TRACKER_RANK, MPI_COMM_WORLD);
+
+    vector<char> names(nr_ids * MAX_FILENAME);
+    MPI_Bcast(names.data(), names.size(), MPI_CHAR, TRACKER_RANK, MPI_COMM_WORLD);
+
+    file_ids.assign(nr_files, NOT_FOUND);
+    local_file_index.assign(nr_ids, NOT_FOUND);
+
+    for (int id = 0; id < nr_ids; id++) {
+        const char* name = names.data() + id * MAX_FILENAME;
+        for (int i = 0; i < nr_files; i++) {
+            if (strncmp(files[i].filename, name, MAX_FILENAME) == 0) {
+                file_ids[i] = id;
+                local_file_index[id] = i;
+                break;
+            }
+        }
+    }
+}
+
+/* fisierul de output (hash-urile pe linii, fara newline dupa ultimul) are dimensiunea cunoscuta
+de la inceputul descarcarii, deci il prealocam si il mapam; chunk-ul i incepe la i * (HASH_SIZE + 1).
+Un output ramas de la o rulare intrerupta, cu fisierul lui de progres, e pastrat pentru reluare
+(intoarce true); altfel descarcarea incepe de la zero */
+bool PeerManager::open_output_file(int index) {
     char output_file_name[MAX_OUTPUT_FILENAME];
     sprintf(output_file_name, "client%d_%s", rank, files[index].filename);
 
-    ofstream fout(output_file_name);
-    if (!fout.is_open()) {
+    output_file& out = downloads[index].output;
+    int nr_chunks = files[index].nr_total_chunks;
+    out.size = nr_chunks > 0 ? (size_t)nr_chunks * (HASH_SIZE + 1) - 1 : 0;
+    out.data = nullptr;
+
+    struct stat st;
+    out.fd = open(output_file_name, O_RDWR | O_CREAT, 0644);
+    bool resumed = out.fd >= 0 && fstat(out.fd, &st) == 0 && (size_t)st.st_size == out.size
+                   && open_progress_file(index, true);
+    if (!resumed) {
+        open_progress_file(index, false);
+    }
+
+    if (out.fd < 0 || (!resumed && ftruncate(out.fd, 0) != 0) || ftruncate(out.fd, out.size) != 0) {
         cerr << "[Peer " << rank << "] Error opening output file: " << output_file_name << endl;
         exit(-1);
     }
 
-    // scriem hash-urile detinute in ordine
-    for (int i = 0; i < nr_owned_chunks[index] - 1; i++) {
-        fout.write(files[index].identifiers[i].hash, HASH_SIZE);
-        fout << endl;
+    if (out.size == 0) {
+        return resumed;
+    }
+
+    void* data = mmap(nullptr, out.size, PROT_READ | PROT_WRITE, MAP_SHARED, out.fd, 0);
+    if (data == MAP_FAILED) {
+        cerr << "[Peer " << rank << "] Error mapping output file: " << output_file_name << endl;
+        exit(-1);
+    }
+    out.data = static_cast<char*>(data);
+
+    // chunk-urile sosesc in ordinea data de rarest-first, nu secvential
+    madvise(out.data, out.size, MADV_RANDOM);
+    return resumed;
+}
+
+/* fisierul de progres ("client<rank>_<fisier>.progress") tine un bit pentru fiecare chunk al
+carui hash e deja in output. E mapat, deci bitii ajung in fisier si daca procesul e oprit brusc.
+Cu "resume", il pastreaza doar daca e al aceluiasi fisier (intoarce false altfel); fara, il
+reinitializeaza gol */
+bool PeerManager::open_progress_file(int index, bool resume) {
+    char progress_file_name[MAX_PROGRESS_FILENAME];
+    sprintf(progress_file_name, "client%d_%s" PROGRESS_SUFFIX, rank, files[index].filename);
+
+    output_file& out = downloads[index].output;
+    int nr_chunks = files[index].nr_total_chunks;
+    out.progress_size = sizeof(progress_header) + bitmap::words_for(nr_chunks) * sizeof(uint64_t);
+
+    struct stat st;
+    out.progress_fd = open(progress_file_name, resume ? O_RDWR : O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (resume && (out.progress_fd < 0 || fstat(out.progress_fd, &st) != 0 || (size_t)st.st_size != out.progress_size)) {
+        if (out.progress_fd >= 0) {
+            close(out.progress_fd);
+        }
+        return false;
+    }
+    if (out.progress_fd < 0 || (!resume && ftruncate(out.progress_fd, out.progress_size) != 0)) {
+        cerr << "[Peer " << rank << "] Error opening progress file: " << progress_file_name << endl;
+        exit(-1);
+    }
+
+    void* data = mmap(nullptr, out.progress_size, PROT_READ | PROT_WRITE, MAP_SHARED, out.progress_fd, 0);
+    if (data == MAP_FAILED) {
+        cerr << "[Peer " << rank << "] Error mapping progress file: " << progress_file_name << endl;
+        exit(-1);
+    }
+    out.progress = static_cast<progress_header*>(data);
+    out.progress_words = reinterpret_cast<uint64_t*>(out.progress + 1);
+
+    if (resume && (out.progress->magic != PROGRESS_MAGIC || out.progress->nr_chunks != nr_chunks)) {
+        munmap(data, out.progress_size);
+        close(out.progress_fd);
+        return false;
+    }
+    if (!resume) {
+        out.progress->magic = PROGRESS_MAGIC;
+        out.progress->nr_chunks = nr_chunks;
+    }
+    return true;
+}
+
+/* chunk-urile marcate in fisierul de progres sunt bune daca hash-urile din output sunt cele din
+metadate: le decodam pe toate si le comparam intr-un singur apel verify_digests (in lot, SIMD) */
+void PeerManager::verify_resumed_chunks(int file_index, const int* chunk_indices, int n, char* ok) {
+    const file_data& meta = downloads[file_index].swarm.file_metadata;
+    vector<identifier> got(n), expected(n);
+    vector<char> decoded(n);
+
+    for (int i = 0; i < n; i++) {
+        const char* hex = downloads[file_index].output.data + (size_t)chunk_indices[i] * (HASH_SIZE + 1);
+        decoded[i] = hex_to_identifier(hex, got[i]);
+        expected[i] = meta.identifiers[chunk_indices[i]];
+    }
+    verify_digests(got.data(), expected.data(), n, ok);
+    for (int i = 0; i < n; i++) {
+        ok[i] = ok[i] && decoded[i];
+    }
+    if (config.chunk_size == 0) {
+        return;
+    }
+
+    // continutul nu e in output, il refacem din hash (ca la seed-uri) si il verificam
+    for (int i = 0; i < n; i++) {
+        int c = chunk_indices[i];
+        if (!ok[i] || c >= (int)meta.payload_digests.size()) {
+            ok[i] = false;
+            continue;
+        }
+        sha256_digest digest;
+        char* data = chunk_payload(file_index, c);
+        fill_payload(got[i], data);
+        sha256(data, config.chunk_size, digest);
+        ok[i] = memcmp(digest.bytes, meta.payload_digests[c].bytes, SHA256_SIZE) == 0;
+    }
+}
+
+// o parte din chunk-urile de reverificat, pentru un thread
+struct resume_job {
+    PeerManager* pm;
+    int file_index;
+    const vector<int>* chunks;
+    int begin;
+    int end;
+    vector<char>* ok;
+};
+
+static void* resume_thread_func(void* arg) {
+    resume_job* job = static_cast<resume_job*>(arg);
+    if (job->end > job->begin) {
+        job->pm->verify_resumed_chunks(job->file_index, job->chunks->data() + job->begin, job->end - job->begin,
+                                       job->ok->data() + job->begin);
+    }
+    return nullptr;
+}
+
+/* reia o descarcare intrerupta: chunk-urile marcate in fisierul de progres sunt reverificate in
+paralel, pe toate core-urile (fiecare thread un interval, cel putin RESUME_CHUNKS_PER_THREAD
+chunk-uri), deoarece scrierea in output si bitul pot sa nu fi ajuns amandoua pe disc. Cele
+corecte devin detinute si le servim imediat; restul se descarca normal */
+void PeerManager::resume_download(int file_index) {
+    output_file& out = downloads[file_index].output;
+    int nr_chunks = files[file_index].nr_total_chunks;
+    vector<int> marked;
+
+    for (int c = 0; c < nr_chunks; c++) {
+        if ((out.progress_words[c >> 6] >> (c & 63)) & 1) {
+            marked.push_back(c);
+        }
+    }
+    if (marked.empty()) {
+        return;
     }
-    fout.write(files[index].identifiers[nr_owned_chunks[index] - 1].hash, HASH_SIZE); // fara endl la ultimul hash
 
-    fout.close();
+    int nr_marked = marked.size();
+    int nr_threads = max(1L, min(sysconf(_SC_NPROCESSORS_ONLN),
+                                 (long)(nr_marked + RESUME_CHUNKS_PER_THREAD - 1) / RESUME_CHUNKS_PER_THREAD));
+    vector<char> ok(nr_marked);
+    vector<resume_job> jobs(nr_threads);
+    vector<pthread_t> threads(nr_threads);
+
+    // thread-ul curent verifica ultimul interval
+    for (int t = 0; t < nr_threads; t++) {
+        jobs[t] = {this, file_index, &marked, (int)((long)nr_marked * t / nr_threads),
+                   (int)((long)nr_marked * (t + 1) / nr_threads), &ok};
+        if (t + 1 < nr_threads && pthread_create(&threads[t], nullptr, resume_thread_func, &jobs[t]) != 0) {
+            resume_thread_func(&jobs[t]);
+            threads[t] = pthread_self();
+        }
+    }
+    resume_thread_func(&jobs[nr_threads - 1]);
+    for (int t = 0; t + 1 < nr_threads; t++) {
+        if (!pthread_equal(threads[t], pthread_self())) {
+            pthread_join(threads[t], nullptr);
+        }
+    }
+
+    int nr_ok = 0;
+    pthread_mutex_lock(&files_lock);
+    for (int i = 0; i < nr_marked; i++) {
+        int c = marked[i];
+        if (ok[i]) {
+            files[file_index].identifiers[c] = downloads[file_index].swarm.file_metadata.identifiers[c];
+            chunk_state[file_index][c] = CHUNK_OWNED;
+            nr_owned_chunks[file_index]++;
+            nr_ok++;
+        } else {
+            out.progress_words[c >> 6] &= ~((uint64_t)1 << (c & 63));
+        }
+    }
+    pthread_mutex_unlock(&files_lock);
+
+    for (int i = 0; i < nr_marked; i++) {
+        if (ok[i]) {
+            share_chunk(file_index, marked[i]);
+        }
+    }
+    stat_add(CNT_CHUNKS_RESUMED, nr_ok);
+}
+
+// scriem hash-ul unui chunk verificat direct la locul lui in fisier, apoi il marcam in progres
+void PeerManager::write_output_chunk(int index, int chunk_index) {
+    output_file& out = downloads[index].output;
+    char* dst = out.data + (size_t)chunk_index * (HASH_SIZE + 1);
+
+    identifier_to_hex(files[index].identifiers[chunk_index], dst);
+    if (chunk_index + 1 < files[index].nr_total_chunks) {
+        dst[HASH_SIZE] = '\n';
+    }
+    out.progress_words[chunk_index >> 6] |= (uint64_t)1 << (chunk_index & 63);
+}
+
+/* toate hash-urile sunt deja in fisier, doar pornim scrierea pe disc si il inchidem; fisierul
+de progres nu mai e necesar */
+void PeerManager::save_output_file(int index) {
+    output_file& out = downloads[index].output;
+
+    if (out.data != nullptr) {
+        msync(out.data, out.size, MS_ASYNC);
+        munmap(out.data, out.size);
+        out.data = nullptr;
+    }
+    close(out.fd);
+
+    char progress_file_name[MAX_PROGRESS_FILENAME];
+    sprintf(progress_file_name, "client%d_%s" PROGRESS_SUFFIX, rank, files[index].filename);
+    munmap(out.progress, out.progress_size);
+    close(out.progress_fd);
+    unlink(progress_file_name);
+}
+
+// shard-ul de tracker care tine swarm-ul fisierului (pentru id necunoscut, cel principal)
+int PeerManager::tracker_for(int file_index) {
+    int file_id = file_ids[file_index];
+    return file_id == NOT_FOUND ? TRACKER_RANK : file_id % config.nr_trackers;
 }
 
 // cerem de la tracker un update la swarm cu ownerii
-void PeerManager::update_swarm(char *filename) {
-    MPI_Sendrecv(filename, MAX_FILENAME, MPI_CHAR, TRACKER_RANK, MSG_REQ_UPDATE_SWARM,
-                 &(cur_swarm.owners), sizeof(swarm_update), MPI_BYTE, TRACKER_RANK, MSG_UPDATE_SWARM,
-                 MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+void PeerManager::update_swarm(int file_index) {
+    swarm_update_request req;
+    vector<char> buf;
+
+    // trimitem versiunea pe care o avem, tracker-ul raspunde doar cu diferentele
+    req.file_id = file_ids[file_index];
+    req.version = downloads[file_index].swarm.owners.version;
+
+    control->send(&req, sizeof(swarm_update_request), tracker_for(file_index), MSG_REQ_UPDATE_SWARM);
+    control->recv_packed(buf, tracker_for(file_index), MSG_UPDATE_SWARM);
+    stat_add(CNT_BYTES_RECEIVED, buf.size());
+    file_download& dl = downloads[file_index];
+    int old_version = dl.swarm.owners.version;
+    apply_swarm_change(file_index, buf.data());
+
+    /* cat timp tracker-ul nu are nimic nou (seed-urile noi le aflam oricum prin PEX) il
+    intrebam tot mai rar; o schimbare readuce intervalul la minim */
+    if (dl.swarm.owners.version != old_version) {
+        dl.poll_interval = SWARM_POLL_MIN;
+    } else {
+        dl.poll_interval = min(2 * dl.poll_interval, SWARM_POLL_MAX);
+    }
+    dl.next_poll = dl.nr_responses + dl.poll_interval;
+    stat_add(CNT_SWARM_POLLS, 1);
+    queue_have_requests(file_index);
 }
 
-// cerem un chunk de la un peer
-bool PeerManager::request_chunk(int rank_request, int file_index, int chunk_index) {
-    chunk_request req;
-    chunk_response res;
+// aplica un raspuns de update (cerut sau trimis de tracker) peste swarm-ul fisierului
+void PeerManager::apply_swarm_change(int file_index, const char* reply) {
+    file_download& dl = downloads[file_index];
+    int old_version = dl.swarm.owners.version;
 
-    strcpy(req.filename, files[file_index].filename);
-    req.chunk_index = chunk_index;
+    apply_swarm_update_reply(reply, dl.swarm.owners);
+    if (dl.swarm.owners.version != old_version) {
+        dl.picker.update_seeds(dl.swarm.owners);
+        publish_seeds(file_index);
+    }
+}
+
+/* prelucreaza notificarea tocmai primita in push_buf, intoarce true daca a schimbat un swarm;
+una mai veche decat ce avem deja (de la un update cerut intre timp) se ignora */
+bool PeerManager::take_swarm_push() {
+    // receive-ul se reposteaza imediat, notificarea primita e prelucrata din "buf"
+    vector<char> buf;
+    buf.swap(push_buf);
+    control->irecv_packed(push_buf, XFER_ANY_SOURCE, MSG_SWARM_PUSH, push_req);
+    stat_add(CNT_BYTES_RECEIVED, buf.size());
 
-    MPI_Sendrecv(&req, sizeof(chunk_request), MPI_BYTE, rank_request, MSG_CHUNK_REQUEST,
-                 &res, sizeof(chunk_response), MPI_BYTE, rank_request, MSG_CHUNK_RESPONSE,
-                 MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+    int file_id;
+    swarm_update_header header;
+    memcpy(&file_id, buf.data(), sizeof(int));
+    memcpy(&header, buf.data() + sizeof(int), sizeof(swarm_update_header));
 
-    if (!res.has_chunk) {
+    int file_index = NOT_FOUND;
+    if (file_id >= 0 && file_id < (int)local_file_index.size()) {
+        file_index = local_file_index[file_id];
+    }
+    if (file_index == NOT_FOUND || downloads[file_index].status != DOWNLOAD_ACTIVE
+        || header.version <= downloads[file_index].swarm.owners.version) {
         return false;
     }
 
-    // verificam daca hash-ul primit este corect (practic echivalent cu descarcarea)
-    char* verify_hash = cur_swarm.file_metadata.identifiers[chunk_index].hash;
-    if (memcmp(res.hash, verify_hash, HASH_SIZE) != 0) {
-        return false;
+    apply_swarm_change(file_index, buf.data() + sizeof(int));
+    queue_have_requests(file_index);
+    return true;
+}
+
+// primim notificarile sosite deja de la tracker-e, intoarce true daca vreun swarm s-a schimbat
+bool PeerManager::receive_swarm_pushes() {
+    bool changed = false;
+    while (control->test(push_req, nullptr)) {
+        changed |= take_swarm_push();
     }
+    return changed;
+}
 
-    // daca s-a ajuns aici, inseamna ca chunk-ul este corect
-    char* file_hash = files[file_index].identifiers[chunk_index].hash;
-    memcpy(file_hash, res.hash, HASH_SIZE);
+/* asteapta cel mult "timeout_ms" o notificare care schimba un swarm, intoarce true daca a venit;
+thread-ul doarme pe receive-ul postat (wait_for), fara mesaje catre tracker */
+bool PeerManager::wait_swarm_push(int timeout_ms) {
+    uint64_t deadline_ns = stat_now_ns() + (uint64_t)timeout_ms * 1000000;
 
-    nr_owned_chunks[file_index]++;
-    
+    while (!receive_swarm_pushes()) {
+        uint64_t now_ns = stat_now_ns();
+        if (now_ns >= deadline_ns) {
+            return false;
+        }
+        int left_ms = (deadline_ns - now_ns + 999999) / 1000000;
+        if (control->wait_for(push_req, left_ms, nullptr) && take_swarm_push()) {
+            receive_swarm_pushes();
+            return true;
+        }
+    }
     return true;
 }
 
-// Raspunde la cereri de chunk-uri
-void PeerManager::send_chunk(int rank_request) {
-    chunk_request req;
-    chunk_response res;
+/* dupa MSG_ALL_DONE, fiecare tracker ne trimite o notificare goala, ultima de la el; cele
+ramase pana atunci nu mai conteaza */
+void PeerManager::wait_push_end() {
+    int nr_ended = 0;
 
-    MPI_Recv(&req, sizeof(chunk_request), MPI_BYTE, rank_request, MSG_CHUNK_REQUEST, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
- 
-    // cautam fisierul in lista noastra
-    int file_index = NOT_FOUND;
-    for (int i = 0; i < nr_owned_files + 1; i++) { // adaugam +1 si pt cazul in care putem fi peer
-        if (strcmp(files[i].filename, req.filename) == 0) {
-            file_index = i;
-            break;
+    while (true) {
+        control->wait(push_req, nullptr);
+        nr_ended += push_buf.empty();
+        if (nr_ended == config.nr_trackers) {
+            return;
         }
+        control->irecv_packed(push_buf, XFER_ANY_SOURCE, MSG_SWARM_PUSH, push_req);
     }
+}
 
-    // daca nu avem fisierul sau chunk-ul, trimitem raspuns negativ
-    if (file_index == NOT_FOUND || req.chunk_index >= nr_owned_chunks[file_index]) {
-        res.has_chunk = false;
-        MPI_Send(&res, sizeof(chunk_response), MPI_BYTE, rank_request, MSG_CHUNK_RESPONSE, MPI_COMM_WORLD);
+// lista de seed-uri anuntata altora se reface din swarm-ul nostru
+void PeerManager::publish_seeds(int file_index) {
+    bitmap& is_seed = downloads[file_index].swarm.owners.is_seed;
+    vector<int> seeds;
+
+    for (int r = 0; r < is_seed.nr_bits; r++) {
+        if (is_seed.test(r) && r != rank) {
+            seeds.push_back(r);
+        }
+    }
+
+    pthread_mutex_lock(&files_lock);
+    known_seeds[file_index].swap(seeds);
+    pthread_mutex_unlock(&files_lock);
+}
+
+// adaugam la raspuns cateva seed-uri ale fisierului, de la o pozitie aleatoare (apelat sub files_lock)
+void PeerManager::add_gossip(int file_index, chunk_response& res) {
+    res.seed = false;
+    res.nr_pex = 0;
+    if (file_index == NOT_FOUND) {
         return;
     }
 
-    // trimitem raspuns pozitiv
-    res.has_chunk = true;
-    memcpy(res.hash, files[file_index].identifiers[req.chunk_index].hash, HASH_SIZE);
-    MPI_Send(&res, sizeof(chunk_response), MPI_BYTE, rank_request, MSG_CHUNK_RESPONSE, MPI_COMM_WORLD);
+    // un fisier dorit si inca nepornit nu are chunk_state
+    res.seed = !chunk_state[file_index].empty() && nr_owned_chunks[file_index] == files[file_index].nr_total_chunks;
+    vector<int>& seeds = known_seeds[file_index];
+    int start = seeds.empty() ? 0 : rand() % seeds.size();
+    for (int i = 0; i < (int)seeds.size() && res.nr_pex < PEX_MAX_RANKS; i++) {
+        res.pex[res.nr_pex++] = seeds[(start + i) % seeds.size()];
+    }
 }
 
-// functie eurisica pentru alegerea unui seed pentru un chunk
-int PeerManager::find_seed_for_chunk() {
-    int best_seed = NOT_FOUND;
-    int best_usage = BIG_VALUE; // de cate ori am apelat la cel mai bun seeder sau peer
-    int start_index = rand() % numtasks;
-    int nr_tries = 0;
-    int i;
+// seed-urile anuntate de uploader (inclusiv el insusi) intra direct in swarm-ul nostru
+void PeerManager::receive_gossip(inflight_request& slot) {
+    file_download& dl = downloads[slot.file_index];
+    bitmap& is_seed = dl.swarm.owners.is_seed;
+    const chunk_response& res = slot.res;
+    int nr_learned = 0;
 
-    /* incercam intai sa gasim un seed sau peer putin utilizat (facand "nr_tries" incercari de
-    la un index random, pt a fi eficient programul si in cazul in care lista de clienti e mare) */
-    for (int offset = 0; offset < numtasks; offset++) {
-        i = (start_index + offset) % numtasks; // indexul seed-ului sau peer-ului
+    if (dl.status != DOWNLOAD_ACTIVE) {
+        return;
+    }
+
+    auto learn = [&](int r) {
+        if (r >= 0 && r < is_seed.nr_bits && r != rank && !is_seed.test(r)) {
+            is_seed.set(r);
+            nr_learned++;
+        }
+    };
+    if (res.seed) {
+        learn(slot.source);
+    }
+    for (int i = 0; i < res.nr_pex && i < PEX_MAX_RANKS; i++) {
+        learn(res.pex[i]);
+    }
+
+    // versiunea ramane a tracker-ului, urmatorul update ne aduce doar ce nu stim
+    if (nr_learned > 0) {
+        dl.picker.update_seeds(dl.swarm.owners);
+        publish_seeds(slot.file_index);
+        stat_add(CNT_PEX_SEEDS, nr_learned);
+    }
+}
+
+// punem in coada urmatorii (prin rotatie) peeri din swarm de la care vrem bitmap-ul "have"
+void PeerManager::queue_have_requests(int file_index) {
+    file_download& dl = downloads[file_index];
+    swarm_update& owners = dl.swarm.owners;
+    int nr_queued = 0;
+
+    for (int i = 0; i < numtasks && nr_queued < HAVE_REQUESTS_PER_UPDATE; i++) {
+        int r = dl.have_cursor;
+        dl.have_cursor = (dl.have_cursor + 1) % numtasks;
 
-        if (i == rank || i == TRACKER_RANK) {
+        if (r == rank || r < config.nr_trackers || dl.have_queued[r]
+            || !owners.is_peer.test(r) || owners.is_seed.test(r)) {
             continue;
         }
 
-        // vrificam daca seed-ul cu acest index detine chunk-ul (seed-eri au prioritate)
-        if (cur_swarm.owners.is_seed[i]) {
-            if (used_peer[i] < best_usage) {
-                best_seed = i;
-                best_usage = used_peer[i];
-                nr_tries++;
-            }
-        
-        // verificam daca peer-ul cu acest index detine chunk-ul
-        } else if (cur_swarm.owners.is_peer[i]) {
-            // peerii au un "treshold de decizie" mai mare (au sansa mai mica sa detina chunk-ul)
-            if (used_peer[i] << PEER_DECISSION_TRESHOLD < best_usage) {
-                best_seed = i;
-                best_usage = used_peer[i] << PEER_DECISSION_TRESHOLD;
-                nr_tries++;
-            }
+        dl.have_queue.push_back(r);
+        dl.have_queued[r] = true;
+        nr_queued++;
+    }
+}
+
+// cerem swarm-ul complet de la tracker si pregatim tabelele fisierului
+void PeerManager::start_download(int file_index) {
+    file_download& dl = downloads[file_index];
+    file_data& file = files[file_index];
+    vector<char> buf;
+
+    control->send(&file_ids[file_index], sizeof(int), tracker_for(file_index), MSG_REQ_FULL_SWARM);
+    control->recv_packed(buf, tracker_for(file_index), MSG_SWARM_DATA);
+    stat_add(CNT_BYTES_RECEIVED, buf.size());
+    unpack_swarm_data(buf.data(), dl.swarm);
+
+    dl.status = DOWNLOAD_ACTIVE;
+    dl.nr_responses = 0;
+    dl.poll_interval = SWARM_POLL_MIN;
+    dl.next_poll = SWARM_POLL_MIN;
+    dl.picker.init(dl.swarm.file_metadata.nr_total_chunks, numtasks);
+    dl.picker.update_seeds(dl.swarm.owners);
+    dl.have_queue.clear();
+    dl.have_queued.assign(numtasks, false);
+    dl.have_cursor = rand() % numtasks;
+    dl.inflight.assign(dl.swarm.file_metadata.nr_total_chunks, 0);
+
+    // abia acum stim cate chunk-uri are fisierul
+    pthread_mutex_lock(&files_lock);
+    file.nr_total_chunks = dl.swarm.file_metadata.nr_total_chunks;
+    file.identifiers.resize(file.nr_total_chunks);
+    if (config.chunk_size > 0) {
+        alloc_payload(file_index);
+    }
+    chunk_state[file_index].assign(file.nr_total_chunks, CHUNK_MISSING);
+    store.map_file(file_index, dl.swarm.file_metadata.identifiers);
+    pthread_mutex_unlock(&files_lock);
+
+    if (open_output_file(file_index)) {
+        resume_download(file_index);
+    }
+
+    // ce avem deja din alte fisiere nu mai cerem nimanui
+    for (int c = 0; c < file.nr_total_chunks; c++) {
+        fetch_local(file_index, c);
+    }
+
+    publish_seeds(file_index);
+    queue_have_requests(file_index);
+}
+
+// salvam fisierul si trimitem o confirmare la tracker
+void PeerManager::finish_download(int file_index) {
+    downloads[file_index].status = DOWNLOAD_DONE;
+
+    save_output_file(file_index);
+    nr_owned_files++;
+    control->send(&file_ids[file_index], sizeof(int), tracker_for(file_index), MSG_FILE_DONE);
+}
+
+// trimitem (non-blocant) cererea pentru un chunk si postam receive-ul pentru raspuns
+void PeerManager::request_chunk(inflight_request& slot, xfer_request& recv_req, int rank_request,
+                                int file_index, int chunk_index) {
+    slot.source = rank_request;
+    slot.file_index = file_index;
+    slot.req.type = REQUEST_CHUNK;
+    slot.req.file_id = file_ids[file_index];
+    slot.req.chunk_index = chunk_index;
+    slot.req.id = downloads[file_index].swarm.file_metadata.identifiers[chunk_index];
+
+    pthread_mutex_lock(&files_lock);
+    chunk_state[file_index][chunk_index] = CHUNK_REQUESTED;
+    pthread_mutex_unlock(&files_lock);
+
+    file_download& dl = downloads[file_index];
+    slot.to_scratch = dl.inflight[chunk_index]++ > 0;
+    if (slot.to_scratch) {
+        stat_add(CNT_ENDGAME_DUPLICATES, 1);
+    }
+
+    /* receive-ul se posteaza inaintea cererii, ca raspunsul sa nu ajunga neasteptat; tag-ul
+    lui e unic per slot, deci nu conteaza in ce ordine raspunde uploader-ul */
+    slot.sent_ns = stat_now_ns();
+    selector.on_request(rank_request);
+    stat_add(CNT_BYTES_SENT, sizeof(chunk_request));
+    transport->irecv(&slot.res, sizeof(chunk_response), rank_request, MSG_CHUNK_RESPONSE + slot.req.token, recv_req);
+
+    // continutul vine dupa raspuns pe acelasi tag, direct la locul lui in fisier (duplicatele in slot)
+    slot.payload_req = xfer_request();
+    if (config.chunk_size > 0) {
+        char* dst = chunk_payload(file_index, chunk_index);
+        if (slot.to_scratch) {
+            slot.scratch.resize(config.chunk_size);
+            dst = slot.scratch.data();
         }
+        transport->irecv(dst, config.chunk_size, rank_request, MSG_CHUNK_RESPONSE + slot.req.token, slot.payload_req);
+    }
+    transport->isend(&slot.req, sizeof(chunk_request), rank_request, MSG_CHUNK_REQUEST, slot.send_req);
+}
 
-        if (nr_tries >= FIND_NUM_TRIES) {
-            break;
+// cerem unui peer bitmap-ul cu chunk-urile pe care le are din fisier
+void PeerManager::request_have(inflight_request& slot, xfer_request& recv_req, int rank_request, int file_index) {
+    slot.source = rank_request;
+    slot.file_index = file_index;
+    slot.req.type = REQUEST_HAVE;
+    slot.req.file_id = file_ids[file_index];
+    slot.req.chunk_index = NOT_FOUND;
+    memset(&slot.req.id, 0, sizeof(identifier));
+
+    // peer-ul poate inca sa nu stie cate chunk-uri are fisierul, atunci trimite mai putin
+    slot.have_words.assign(bitmap::words_for(files[file_index].nr_total_chunks), 0);
+    stat_add(CNT_BYTES_SENT, sizeof(chunk_request));
+
+    transport->irecv(slot.have_words.data(), slot.have_words.size() * sizeof(uint64_t), rank_request,
+                     MSG_CHUNK_RESPONSE + slot.req.token, recv_req);
+    transport->isend(&slot.req, sizeof(chunk_request), rank_request, MSG_CHUNK_REQUEST, slot.send_req);
+}
+
+// inregistram ce chunk-uri are peer-ul ("len" octeti primiti)
+void PeerManager::receive_have(inflight_request& slot, int len) {
+    file_download& dl = downloads[slot.file_index];
+
+    transport->wait(slot.send_req, nullptr);
+    stat_add(CNT_BYTES_RECEIVED, len);
+
+    dl.picker.update_have(slot.source, slot.have_words.data(), len / sizeof(uint64_t));
+    dl.have_queued[slot.source] = false;
+}
+
+/* un duplicat a castigat chunk-ul, deci receive-ul primei cereri (direct in fisier) nu mai are voie
+sa scrie acolo dupa ce chunk-ul devine detinut. Il anulam; daca mesajul nu a sosit inca, il
+asteptam in bufferul slot-ului, ca sa nu ramana nepotrivit pe tag-ul refolosit al slot-ului.
+Daca a sosit, e deja scris si va fi suprascris de castigator */
+void PeerManager::redirect_payload(vector<inflight_request>& slots, int file_index, int chunk_index) {
+    for (inflight_request& other : slots) {
+        if (!other.payload_req.active() || other.to_scratch || other.req.type != REQUEST_CHUNK
+            || other.file_index != file_index || other.req.chunk_index != chunk_index) {
+            continue;
+        }
+        if (transport->cancel(other.payload_req)) {
+            other.scratch.resize(config.chunk_size);
+            transport->irecv(other.scratch.data(), config.chunk_size, other.source,
+                             MSG_CHUNK_RESPONSE + other.req.token, other.payload_req);
         }
+        other.to_scratch = true;
     }
+}
+
+/* procesam raspunsul unei cereri terminate, intoarce true daca am obtinut chunk-ul;
+"digest_ok" vine din verificarea (in lot) a digest-ului primit cu cel din metadate */
+bool PeerManager::receive_chunk(inflight_request& slot, vector<inflight_request>& slots, bool digest_ok) {
+    int file_index = slot.file_index;
+    int chunk_index = slot.req.chunk_index;
+    file_download& dl = downloads[file_index];
+
+    // raspunsul a sosit, deci si cererea a fost livrata
+    transport->wait(slot.send_req, nullptr);
+    // fara payload, cererea e deja nula si nu se asteapta nimic
+    xfer_status payload_status;
+    transport->wait(slot.payload_req, &payload_status);
+    int payload_len = payload_status.count;
+    uint64_t latency_ns = stat_now_ns() - slot.sent_ns;
+    stat_record(OP_REQUEST_CHUNK, slot.sent_ns);
+    stat_add(CNT_BYTES_RECEIVED, sizeof(chunk_response) + payload_len);
+    dl.inflight[chunk_index]--;
 
-    if (best_seed != NOT_FOUND) {
-        used_peer[best_seed]++;
+    // hash-ul corect e practic echivalent cu descarcarea
+    const char* payload = slot.to_scratch ? slot.scratch.data() : chunk_payload(file_index, chunk_index);
+    bool valid = slot.res.has_chunk && slot.res.chunk_index == chunk_index && digest_ok
+                 && verify_payload(file_index, chunk_index, payload, payload_len);
+
+    // in endgame alta cerere pentru acelasi chunk poate sa fi castigat deja (doar thread-ul asta il marcheaza)
+    bool duplicate = chunk_state[file_index][chunk_index] == CHUNK_OWNED;
+    if (duplicate) {
+        stat_add(CNT_ENDGAME_WASTED, 1);
+    } else {
+        if (valid && config.chunk_size > 0 && slot.to_scratch) {
+            // chunk-ul nu e inca detinut, deci thread-ul de upload nu il citeste in timpul copierii
+            redirect_payload(slots, file_index, chunk_index);
+            memcpy(chunk_payload(file_index, chunk_index), slot.scratch.data(), payload_len);
+        }
+
+        pthread_mutex_lock(&files_lock);
+        if (valid) {
+            // daca s-a ajuns aici, inseamna ca chunk-ul este corect
+            files[file_index].identifiers[chunk_index] = slot.res.id;
+            chunk_state[file_index][chunk_index] = CHUNK_OWNED;
+            nr_owned_chunks[file_index]++;
+            received_from[slot.source]++;
+        } else {
+            // ramane cerut cat timp mai asteptam un duplicat
+            chunk_state[file_index][chunk_index] = dl.inflight[chunk_index] > 0 ? CHUNK_REQUESTED : CHUNK_MISSING;
+        }
+        pthread_mutex_unlock(&files_lock);
     }
 
-    return best_seed;
+    // un refuz sau un raspuns gresit scad rata de succes a sursei
+    selector.on_response(slot.source, latency_ns, valid);
+    receive_gossip(slot);
+
+    // un uploader ocupat ne refuza imediat; il ocolim pana la urmatoarea lui reevaluare
+    if (slot.res.choked) {
+        choked_until[slot.source] = stat_now_ns() + (uint64_t)CHOKED_BACKOFF_MS * 1000000;
+        stat_add(CNT_CHOKED_RECEIVED, 1);
+    } else if (!duplicate) {
+        stat_add(valid ? CNT_CHUNKS_RECEIVED : CNT_CHUNKS_FAILED, 1);
+    }
+    if (duplicate) {
+        return false;
+    }
+    if (valid) {
+        write_output_chunk(file_index, chunk_index);
+        stat_add(CNT_PAYLOAD_BYTES, payload_len);
+        share_chunk(file_index, chunk_index);
+    }
+    return valid;
 }
 
-// descarcam un fisier folosind swarm-ul primit de la tracker
-void PeerManager::download_file_using_swarm(int file_index) {
-    file_data& file = files[file_index];
-    file.nr_total_chunks = cur_swarm.file_metadata.nr_total_chunks;
+/* completeaza un chunk lipsa al unei descarcari din copia detinuta a aceluiasi continut (alt
+fisier sau alt loc din acelasi fisier), intoarce true daca a reusit. In modul cu payload copia
+e verificata cu SHA-256-ul asteptat, ca un hash identic cu continut diferit sa fie cerut normal */
+bool PeerManager::fetch_local(int file_index, int chunk_index) {
+    chunk_ref src;
+    if (chunk_state[file_index][chunk_index] != CHUNK_MISSING
+        || !store.find_held(store.entry_of(file_index, chunk_index), src)) {
+        return false;
+    }
+
+    // sursa e detinuta, deci nu se mai schimba; destinatia lipseste, deci nu o citeste nimeni
+    if (config.chunk_size > 0) {
+        const char* data = chunk_payload(src.file_index, src.chunk_index);
+        if (!verify_payload(file_index, chunk_index, data, config.chunk_size)) {
+            return false;
+        }
+        memcpy(chunk_payload(file_index, chunk_index), data, config.chunk_size);
+    }
+
+    pthread_mutex_lock(&files_lock);
+    files[file_index].identifiers[chunk_index] = files[src.file_index].identifiers[src.chunk_index];
+    chunk_state[file_index][chunk_index] = CHUNK_OWNED;
+    nr_owned_chunks[file_index]++;
+    pthread_mutex_unlock(&files_lock);
+
+    write_output_chunk(file_index, chunk_index);
+    stat_add(CNT_CHUNKS_LOCAL, 1);
+    return true;
+}
+
+// un chunk abia obtinut completeaza si celelalte aparitii lipsa ale continutului lui
+void PeerManager::share_chunk(int file_index, int chunk_index) {
+    int entry = store.entry_of(file_index, chunk_index);
+
+    pthread_mutex_lock(&files_lock);
+    store.set_held(file_index, chunk_index);
+    pthread_mutex_unlock(&files_lock);
+
+    for (const chunk_ref& use : store.uses(entry)) {
+        if (downloads[use.file_index].status == DOWNLOAD_ACTIVE) {
+            fetch_local(use.file_index, use.chunk_index);
+        }
+    }
+}
+
+// in modul cu payload chunk-ul e descarcat doar daca SHA-256-ul continutului primit e cel anuntat
+bool PeerManager::verify_payload(int file_index, int chunk_index, const char* data, int len) {
+    if (config.chunk_size == 0) {
+        return true;
+    }
+
+    vector<sha256_digest>& digests = downloads[file_index].swarm.file_metadata.payload_digests;
+    if (len != config.chunk_size || chunk_index >= (int)digests.size()) {
+        return false;
+    }
 
-    if (nr_owned_chunks[file_index] == file.nr_total_chunks && nr_owned_chunks[file_index] > 0) {
-        cout << "STH WENR WRONG IN DOWNLOAD_FILE_USING_SWARM\n";
+    stat_timer timer(OP_VERIFY_CHUNK);
+    sha256_digest digest;
+    sha256(data, len, digest);
+    return memcmp(digest.bytes, digests[chunk_index].bytes, SHA256_SIZE) == 0;
+}
+
+/* construieste raspunsul la o cerere de chunk, intoarce continutul de trimis (nullptr daca nu e);
+un chunk pe care nu il avem in fisierul cerut poate veni din alt fisier cu acelasi hash */
+const char* PeerManager::serve_chunk(const chunk_request& req, chunk_response& res) {
+    const char* payload = nullptr;
+
+    // cautam fisierul in lista noastra (inclusiv cele descarcate partial)
+    int file_index = NOT_FOUND;
+    if (req.file_id >= 0 && req.file_id < (int)local_file_index.size()) {
+        file_index = local_file_index[req.file_id];
+    }
+
+    res.chunk_index = req.chunk_index;
+    res.has_chunk = false;
+    res.choked = false;
+
+    // daca nu avem fisierul sau chunk-ul, trimitem raspuns negativ
+    pthread_mutex_lock(&files_lock);
+    chunk_ref src = {NOT_FOUND, NOT_FOUND};
+    if (file_index != NOT_FOUND && req.chunk_index >= 0
+        && req.chunk_index < (int)chunk_state[file_index].size()
+        && chunk_state[file_index][req.chunk_index] == CHUNK_OWNED) {
+        src = {file_index, req.chunk_index};
+    } else if (store.find_held(req.id, src)) {
+        stat_add(CNT_CHUNKS_BY_DIGEST, 1);
+    }
+
+    if (src.file_index != NOT_FOUND) {
+        res.has_chunk = true;
+        res.id = files[src.file_index].identifiers[src.chunk_index];
+
+        // un chunk detinut nu se mai schimba, deci poate fi trimis si dupa eliberarea lock-ului
+        if (payloads[src.file_index] != nullptr) {
+            payload = chunk_payload(src.file_index, src.chunk_index);
+        }
+    }
+    add_gossip(file_index, res);
+    pthread_mutex_unlock(&files_lock);
+
+    return payload;
+}
+
+// construieste bitmap-ul cu chunk-urile detinute din fisierul cerut
+void PeerManager::serve_have(const chunk_request& req, vector<uint64_t>& words) {
+    int file_index = NOT_FOUND;
+    if (req.file_id >= 0 && req.file_id < (int)local_file_index.size()) {
+        file_index = local_file_index[req.file_id];
+    }
+
+    words.clear();
+    if (file_index == NOT_FOUND) {
         return;
     }
 
-    int count = 1;
-    int cur_chk;
-    int seed_chosen;
+    pthread_mutex_lock(&files_lock);
+    vector<char>& state = chunk_state[file_index];
+    words.assign(bitmap::words_for(state.size()), 0);
+    for (int c = 0; c < (int)state.size(); c++) {
+        if (state[c] == CHUNK_OWNED) {
+            words[c >> 6] |= (uint64_t)1 << (c & 63);
+        }
+    }
+    pthread_mutex_unlock(&files_lock);
+}
+
+// alegem sursa unui chunk, doar dintre cei care sigur il au (vezi selector.h)
+int PeerManager::find_seed_for_chunk(int file_index, int chunk_index, const vector<int>& exclude) {
+    stat_timer timer(OP_FIND_SEED);
+    file_download& dl = downloads[file_index];
+    uint64_t now_ns = stat_now_ns();
 
-    // loop pana cand avem toate chunk-urile
-    while (nr_owned_chunks[file_index] < file.nr_total_chunks) {
-        cur_chk = nr_owned_chunks[file_index]; // = 0 la inceput
+    // seed-urile au tot fisierul, iar peerii doar ce au anuntat in bitmap-ul "have"
+    return selector.pick([&](int i) {
+        return i != rank && i >= config.nr_trackers && choked_until[i] <= now_ns
+               && dl.picker.holds(dl.swarm.owners, i, chunk_index)
+               && find(exclude.begin(), exclude.end(), i) == exclude.end();
+    });
+}
+
+/* endgame: cand dintr-un fisier au ramas cel mult "--endgame" chunk-uri si toate sunt deja cerute,
+cerem din nou chunk-ul cu cele mai putine cereri in curs, de la o sursa care nu il are deja de
+trimis; primul raspuns corect castiga, iar celelalte sunt ignorate la sosire */
+int PeerManager::pick_endgame_chunk(int file_index, const vector<inflight_request>& slots,
+                                    const vector<xfer_request>& recv_reqs, int& source) {
+    file_download& dl = downloads[file_index];
+    int nr_chunks = files[file_index].nr_total_chunks;
+    if (nr_chunks - nr_owned_chunks[file_index] > config.endgame_threshold) {
+        return NOT_FOUND;
+    }
 
-        // alegem un seed pentru chunk-ul curent
-        seed_chosen = find_seed_for_chunk();
-        request_chunk(seed_chosen, file_index, cur_chk);
+    int best = NOT_FOUND;
+    vector<int> exclude;
+    for (int c = 0; c < nr_chunks; c++) {
+        if (chunk_state[file_index][c] != CHUNK_REQUESTED || dl.inflight[c] >= ENDGAME_MAX_REQUESTS
+            || (best != NOT_FOUND && dl.inflight[c] >= dl.inflight[best])) {
+            continue;
+        }
+
+        // sursele la care chunk-ul e deja cerut
+        exclude.clear();
+        for (int s = 0; s < (int)slots.size(); s++) {
+            if (recv_reqs[s].active() && slots[s].req.type == REQUEST_CHUNK
+                && slots[s].file_index == file_index && slots[s].req.chunk_index == c) {
+                exclude.push_back(slots[s].source);
+            }
+        }
 
-        // la fiecare 10 chunk-uri cerem un update la swarm
-        if ((count % 10) == 0) {
-            update_swarm(file.filename);
+        int seed = find_seed_for_chunk(file_index, c, exclude);
+        if (seed != NOT_FOUND) {
+            best = c;
+            source = seed;
         }
-        count++;
     }
+    return best;
 }
 
-void* download_thread_func(void* arg) {
-    PeerManager* pm = static_cast<PeerManager*>(arg);
-    MPI_Status status;
+/* descarcam toate fisierele dorite intr-o singura bucla de evenimente: pana la
+"--parallel-files" fisiere sunt active simultan si isi impart fereastra de cereri */
+void PeerManager::download_wanted_files() {
+    int window = config.download_window;
+    vector<inflight_request> slots(window);
+    vector<xfer_request> recv_reqs(window);
+    vector<xfer_status> statuses(window);
+    vector<int> done_slots(window);
+    // digest-urile primite intr-un lot de raspunsuri si cele asteptate, comparate deodata
+    vector<identifier> got(window), expected(window);
+    vector<char> digest_ok(window);
+
+    vector<int> active; // fisierele in curs de descarcare
+    vector<int> order;  // ordinea in care le pornim
+    int next_wanted = 0;
+    int nr_inflight = 0;
+    int nr_have_inflight = 0;
+    int max_have_inflight = max(1, window / 4); // cererile "have" nu ocupa toata fereastra
+    int nr_done = 0;
+    int turn = 0; // de la ce fisier activ incepem la umplerea ferestrei
+    int idle_wait_ms = PUSH_IDLE_MIN_MS; // cat asteptam o notificare cand nu avem ce cere
+
+    downloads.resize(nr_files);
+    for (int i = nr_owned_files; i < nr_files; i++) {
+        downloads[i].status = DOWNLOAD_PENDING;
+    }
+    /* descarcarile intrerupte (cu fisier de progres) le pornim primele, ca sa ne inregistram
+    repede in swarm-urile lor si sa servim chunk-urile pe care le avem deja */
+    char progress_file_name[MAX_PROGRESS_FILENAME];
+    for (int pass = 0; pass < 2; pass++) {
+        for (int i = nr_owned_files; i < nr_files; i++) {
+            sprintf(progress_file_name, "client%d_%s" PROGRESS_SUFFIX, rank, files[i].filename);
+            if ((access(progress_file_name, F_OK) == 0) == (pass == 0)) {
+                order.push_back(i);
+            }
+        }
+    }
+    for (int slot = 0; slot < window; slot++) {
+        slots[slot].req.token = slot;
+    }
+    if (config.swarm_push) {
+        control->irecv_packed(push_buf, XFER_ANY_SOURCE, MSG_SWARM_PUSH, push_req);
+    }
+
+    while (true) {
+        // pornim fisiere noi cat timp avem loc
+        while ((int)active.size() < config.parallel_downloads && next_wanted < (int)order.size()) {
+            start_download(order[next_wanted]);
+            active.push_back(order[next_wanted++]);
+        }
+
+        // fisierele complete se salveaza, iar locul lor e luat de urmatoarele
+        bool finished_some = false;
+        for (int i = 0; i < (int)active.size(); i++) {
+            int file_index = active[i];
+            if (nr_owned_chunks[file_index] == files[file_index].nr_total_chunks) {
+                finish_download(file_index);
+                active.erase(active.begin() + i--);
+                finished_some = true;
+            }
+        }
+        if (finished_some) {
+            continue;
+        }
+        // raspunsurile duplicatelor din endgame pot sosi si dupa ce s-au terminat toate fisierele
+        if (active.empty() && nr_inflight == 0) {
+            break;
+        }
+
+        // umplem fereastra cu cereri noi, luand pe rand fisierele active
+        for (int slot = 0; slot < window; slot++) {
+            if (recv_reqs[slot].active()) {
+                continue;
+            }
+
+            // cautam, incepand cu fisierul de la rand, unul care are ce cere si de la cine
+            int file_index = NOT_FOUND;
+            int chk = NOT_FOUND;
+            int seed_chosen = NOT_FOUND;
+            for (int tries = 0; tries < (int)active.size() && file_index == NOT_FOUND; tries++) {
+                int candidate = active[turn++ % active.size()];
+                file_download& dl = downloads[candidate];
+
+                // intai aflam ce au peerii, ca sa stim de la cine putem cere
+                if (!dl.have_queue.empty() && nr_have_inflight < max_have_inflight) {
+                    seed_chosen = dl.have_queue.back();
+                    dl.have_queue.pop_back();
+                    file_index = candidate;
+                    chk = NOT_FOUND;
+                    break;
+                }
+
+                chk = dl.picker.next_chunk(chunk_state[candidate]);
+                if (chk == NOT_FOUND) {
+                    // nimic nou de cerut: spre final dublam cererile pentru chunk-urile ramase
+                    chk = pick_endgame_chunk(candidate, slots, recv_reqs, seed_chosen);
+                    if (chk != NOT_FOUND) {
+                        file_index = candidate;
+                    }
+                    continue;
+                }
+
+                seed_chosen = find_seed_for_chunk(candidate, chk);
+                if (seed_chosen != NOT_FOUND) {
+                    file_index = candidate;
+                }
+            }
+            if (file_index == NOT_FOUND) {
+                break;
+            }
+
+            if (chk == NOT_FOUND) {
+                request_have(slots[slot], recv_reqs[slot], seed_chosen, file_index);
+                nr_have_inflight++;
+            } else {
+                request_chunk(slots[slot], recv_reqs[slot], seed_chosen, file_index, chk);
+            }
+            nr_inflight++;
+        }
 
-    // astptam semnal de la tracker
-    MPI_Recv(nullptr, 0, MPI_CHAR, TRACKER_RANK, MSG_CLIENT_READY_DOWNLOAD, MPI_COMM_WORLD, &status);
+        /* nu avem de la cine cere, asteptam ca swarm-urile sa se schimbe: cu notificari, tracker-ul
+        e intrebat doar daca nu vine niciuna in intervalul de asteptare (adaptiv) */
+        if (nr_inflight == 0) {
+            if (config.swarm_push) {
+                if (wait_swarm_push(idle_wait_ms)) {
+                    idle_wait_ms = PUSH_IDLE_MIN_MS;
+                    continue;
+                }
+                idle_wait_ms = min(2 * idle_wait_ms, PUSH_IDLE_MAX_MS);
+            } else if (*max_element(choked_until.begin(), choked_until.end()) > stat_now_ns()) {
+                // daca sursele ne-au refuzat, nu bombardam tracker-ul pana expira refuzurile
+                usleep(1000);
+            }
+            for (int file_index : active) {
+                update_swarm(file_index);
+            }
+            continue;
+        }
+        idle_wait_ms = PUSH_IDLE_MIN_MS;
 
-    // pt fiecare fisier dorit, cerem swarm-ul si descarcam
-    for (int i = pm->nr_owned_files; i < pm->nr_files; i++) {
-        file_data& file = pm->files[i];
+        if (config.swarm_push) {
+            receive_swarm_pushes();
+        }
 
-        // cerem swarm-ul de la tracker
-        MPI_Sendrecv(file.filename, MAX_FILENAME, MPI_CHAR, TRACKER_RANK, MSG_REQ_FULL_SWARM,
-                     &(pm->cur_swarm), sizeof(swarm_data), MPI_BYTE, TRACKER_RANK, MSG_SWARM_DATA,
-                     MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+        // raspunsurile pot veni in orice ordine si pentru orice fisier
+        transport->waitsome(window, recv_reqs.data(), nr_done, done_slots.data(), statuses.data());
 
-        // acum descarcam fisierul
-        pm->download_file_using_swarm(i);
+        for (int i = 0; i < nr_done; i++) {
+            inflight_request& slot = slots[done_slots[i]];
+            if (slot.req.type == REQUEST_CHUNK) {
+                got[i] = slot.res.id;
+                expected[i] = downloads[slot.file_index].swarm.file_metadata.identifiers[slot.req.chunk_index];
+            }
+        }
+        verify_digests(got.data(), expected.data(), nr_done, digest_ok.data());
+
+        for (int i = 0; i < nr_done; i++) {
+            inflight_request& slot = slots[done_slots[i]];
+            file_download& dl = downloads[slot.file_index];
+            nr_inflight--;
+
+            if (slot.req.type == REQUEST_HAVE) {
+                receive_have(slot, statuses[i].count);
+                nr_have_inflight--;
+                continue;
+            }
 
-        // salvam fisieul si trimitem o confirmare la tracker
-        pm->save_output_file(i);
-        pm->nr_owned_files++;
-        MPI_Send(file.filename, MAX_FILENAME, MPI_CHAR, TRACKER_RANK, MSG_FILE_DONE, MPI_COMM_WORLD);
+            // un chunk esuat redevine lipsa, iar picker-ul il gaseste din nou la locul lui
+            receive_chunk(slot, slots, digest_ok[i]);
+
+            /* update-ul swarm-ului de la tracker vine la un interval adaptiv (vezi update_swarm);
+            cu notificari nu il mai cerem, doar continuam rotatia cererilor "have" */
+            dl.nr_responses++;
+            if (dl.nr_responses >= dl.next_poll && dl.status == DOWNLOAD_ACTIVE) {
+                if (config.swarm_push) {
+                    dl.next_poll = dl.nr_responses + SWARM_POLL_MIN;
+                    queue_have_requests(slot.file_index);
+                } else {
+                    update_swarm(slot.file_index);
+                }
+            }
+        }
+    }
+}
+
+void* download_thread_func(void* arg) {
+    PeerManager* pm = static_cast<PeerManager*>(arg);
+    uint64_t start_ns = stat_now_ns();
+    if (pm->engine != nullptr) {
+        pm->engine->attach();
     }
 
-    // am terminat toate fisierele
-    MPI_Send(nullptr, 0, MPI_CHAR, TRACKER_RANK, MSG_ALL_DONE, MPI_COMM_WORLD);
+    // descarcam toate fisierele dorite (salvarea si confirmarile se fac pe masura ce se termina)
+    pm->download_wanted_files();
+    stat_add(CNT_DOWNLOAD_US, (stat_now_ns() - start_ns) / 1000);
 
+    // am terminat toate fisierele, anuntam fiecare shard de tracker
+    for (int t = 0; t < config.nr_trackers; t++) {
+        pm->control->send(nullptr, 0, t, MSG_ALL_DONE);
+    }
+    if (config.swarm_push) {
+        pm->wait_push_end();
+    }
+
+    stats_flush_thread();
+    if (pm->engine != nullptr) {
+        pm->engine->detach();
+    }
     return nullptr;
 }
 
 void* upload_thread_func(void* arg) {
     PeerManager* pm = static_cast<PeerManager*>(arg);
 
+    int nr_slots = config.upload_recv_slots;
+    vector<upload_slot> slots(nr_slots);
+    vector<xfer_request> recv_reqs(nr_slots + 1); // ultimul e pentru stop-ul de la tracker
+    vector<xfer_status> statuses(nr_slots + 1);
+    vector<int> done(nr_slots + 1);
+    int nr_done;
     bool finished = false;
-    MPI_Status status;
-    int source, tag;
+    UploadScheduler scheduler;
+    vector<int> received_from;
+    Transport* transport = pm->transport;
 
-    // asteptam semnal de la tracker
-    MPI_Recv(nullptr, 0, MPI_CHAR, TRACKER_RANK, MSG_CLIENT_READY_UPLOAD, MPI_COMM_WORLD, &status);
+    if (pm->engine != nullptr) {
+        pm->engine->attach();
+    }
+    scheduler.init(pm->numtasks, config.upload_slots);
+
+    // receive-uri persistente, gata oricand pentru cereri de la oricine
+    for (int i = 0; i < nr_slots; i++) {
+        transport->recv_init(&slots[i].req, sizeof(chunk_request), XFER_ANY_SOURCE, MSG_CHUNK_REQUEST, recv_reqs[i]);
+        transport->start(recv_reqs[i]);
+    }
+    transport->irecv(nullptr, 0, TRACKER_RANK, MSG_TRACKER_STOP, recv_reqs[nr_slots]);
 
     while (!finished) {
-        MPI_Probe(MPI_ANY_SOURCE, MPI_ANY_TAG, MPI_COMM_WORLD, &status);
-        tag = status.MPI_TAG;
+        transport->waitsome(nr_slots + 1, recv_reqs.data(), nr_done, done.data(), statuses.data());
 
-        if (tag == MSG_CHUNK_REQUEST) {
-            // cerere de chunk
-            source = status.MPI_SOURCE;
-            pm->send_chunk(source);
-            pm->DEBUG_NR_HELPS++;
+        // periodic reimpartim sloturile dupa cat am primit de la fiecare
+        uint64_t now_ns = stat_now_ns();
+        if (scheduler.rechoke_due(now_ns)) {
+            pthread_mutex_lock(&pm->files_lock);
+            received_from = pm->received_from;
+            pthread_mutex_unlock(&pm->files_lock);
+            scheduler.rechoke(received_from, now_ns);
         }
-        if (tag == MSG_TRACKER_STOP) {
-            // cerere de stop de la tracker
-            source = status.MPI_SOURCE;
-            MPI_Recv(nullptr, 0, MPI_CHAR, source, MSG_TRACKER_STOP, MPI_COMM_WORLD, &status);
-            finished = true;
+
+        // raspundem la toate cererile sosite, fara sa asteptam trimiterile
+        for (int i = 0; i < nr_done; i++) {
+            int idx = done[i];
+            if (idx == nr_slots) {
+                // cerere de stop de la tracker
+                finished = true;
+                continue;
+            }
+
+            upload_slot& slot = slots[idx];
+            transport->wait(slot.send_req, nullptr); // raspunsul anterior din slot
+            transport->wait(slot.payload_req, nullptr);
+            stat_add(CNT_BYTES_RECEIVED, sizeof(chunk_request));
+
+            if (slot.req.type == REQUEST_HAVE) {
+                pm->serve_have(slot.req, slot.have_words);
+                transport->isend(slot.have_words.data(), slot.have_words.size() * sizeof(uint64_t),
+                                 statuses[i].source, MSG_CHUNK_RESPONSE + slot.req.token, slot.send_req);
+                stat_add(CNT_HAVE_SERVED, 1);
+                stat_add(CNT_BYTES_SENT, slot.have_words.size() * sizeof(uint64_t));
+            } else {
+                uint64_t start_ns = stat_now_ns();
+                const char* payload = nullptr;
+                if (scheduler.allow(statuses[i].source)) {
+                    payload = pm->serve_chunk(slot.req, slot.res);
+                } else {
+                    // nu are slot: il refuzam imediat, fara sa-i tinem cererea in asteptare
+                    slot.res.chunk_index = slot.req.chunk_index;
+                    slot.res.has_chunk = false;
+                    slot.res.choked = true;
+                    stat_add(CNT_CHOKED_SENT, 1);
+
+                    // si un refuz duce seed-urile mai departe
+                    int file_index = NOT_FOUND;
+                    if (slot.req.file_id >= 0 && slot.req.file_id < (int)pm->local_file_index.size()) {
+                        file_index = pm->local_file_index[slot.req.file_id];
+                    }
+                    pthread_mutex_lock(&pm->files_lock);
+                    pm->add_gossip(file_index, slot.res);
+                    pthread_mutex_unlock(&pm->files_lock);
+                }
+                transport->isend(&slot.res, sizeof(chunk_response), statuses[i].source,
+                                 MSG_CHUNK_RESPONSE + slot.req.token, slot.send_req);
+
+                // continutul pleaca direct din buffer-ul fisierului (gol daca nu avem chunk-ul)
+                int payload_len = payload != nullptr ? config.chunk_size : 0;
+                if (config.chunk_size > 0) {
+                    transport->isend(payload, payload_len, statuses[i].source,
+                                     MSG_CHUNK_RESPONSE + slot.req.token, slot.payload_req);
+                }
+                stat_record(OP_SEND_CHUNK, start_ns);
+                stat_add(CNT_CHUNKS_SERVED, slot.res.has_chunk);
+                stat_add(CNT_BYTES_SENT, sizeof(chunk_response) + payload_len);
+            }
+
+            transport->start(recv_reqs[idx]);
         }
     }
+
+    // anulam receive-urile ramase si asteptam ultimele raspunsuri
+    for (int i = 0; i < nr_slots; i++) {
+        transport->cancel(recv_reqs[i]);
+        transport->wait(slots[i].send_req, nullptr);
+        transport->wait(slots[i].payload_req, nullptr);
+    }
+
+    stats_flush_thread();
+    if (pm->engine != nullptr) {
+        pm->engine->detach();
+    }
     return nullptr;
 }
 
@@ -304,11 +1355,14 @@ void peer(int numtasks, int rank) {
     pthread_t download_thread;
     pthread_t upload_thread;
     void* statusPtr;
+    uint64_t start_ns = stat_now_ns();
 
     PeerManager pm(rank, numtasks);
 
-    pm.send_my_nr_files();
+    // dupa ce primim tabela de id-uri putem incepe (tracker-ul are deja swarm-urile)
     pm.send_own_files_data();
+    pm.receive_file_ids();
+    stat_add(CNT_INIT_US, (stat_now_ns() - start_ns) / 1000);
 
     int r = pthread_create(&download_thread, nullptr, download_thread_func, (void*)&pm);
     if (r) {
@@ -322,6 +1376,11 @@ void peer(int numtasks, int rank) {
         exit(-1);
     }
 
+    // cu --comm-thread, thread-ul principal face apelurile MPI ale celor doua pana se termina
+    if (pm.engine != nullptr) {
+        pm.engine->run(2);
+    }
+
     r = pthread_join(download_thread, &statusPtr);
     if (r) {
         cerr << "[Peer " << rank << "] Error joining download thread.\n";
@@ -333,6 +1392,4 @@ void peer(int numtasks, int rank) {
         cerr << "[Peer " << rank << "] Error joining upload thread.\n";
         exit(-1);
     }
-
-    // cout << "[Peer " << rank << "] Helped " << pm.DEBUG_NR_HELPS << " times.\n";
 } 
\ No newline at end of file
@@ -1,15 +1,96 @@
 #pragma once
 
+#include <mpi.h>
+#include <pthread.h>
+#include <vector>
+#include "picker.h"
+#include "choker.h"
+#include "selector.h"
+#include "transport.h"
+#include "progress.h"
+#include "chunk_store.h"
+
 using namespace std;
 
 struct chunk_request {
-    char filename[MAX_FILENAME];
+    int type;  // REQUEST_CHUNK sau REQUEST_HAVE (bitmap-ul cu chunk-urile detinute din fisier)
+    int file_id;
     int chunk_index;
+    int token; // slot-ul din fereastra cererii, raspunsul vine pe tag-ul MSG_CHUNK_RESPONSE + token
+    identifier id; // hash-ul asteptat: uploader-ul il poate servi si din alt fisier al lui
 };
 
 struct chunk_response {
     bool has_chunk;
-    char hash[HASH_SIZE];
+    bool choked; // uploader-ul nu ne deserveste acum, cerem de la altcineva
+    bool seed;   // uploader-ul are tot fisierul
+    int chunk_index;
+    identifier id;
+    // PEX: seed-uri ale fisierului stiute de uploader, ca sa nu le aflam doar de la tracker
+    int nr_pex;
+    int pex[PEX_MAX_RANKS];
+};
+
+// o cerere de chunk aflata in fereastra de download (trimisa, dar fara raspuns inca)
+struct inflight_request {
+    int source;
+    int file_index;
+    chunk_request req;
+    chunk_response res;
+    vector<uint64_t> have_words; // raspunsul la REQUEST_HAVE
+    xfer_request send_req;
+    xfer_request payload_req;    // continutul chunk-ului, primit direct in fisier sau in "scratch"
+    uint64_t sent_ns;            // momentul trimiterii cererii (pentru latenta)
+    /* doar prima cerere pentru un chunk primeste direct in fisier; duplicatele din endgame primesc
+    aici, iar castigatorul verificat e copiat in fisier inainte sa devina detinut */
+    bool to_scratch;
+    vector<char> scratch;
+};
+
+// un receive persistent al thread-ului de upload, impreuna cu raspunsul trimis din el
+struct upload_slot {
+    chunk_request req;
+    chunk_response res;
+    vector<uint64_t> have_words;
+    xfer_request send_req;
+    xfer_request payload_req;
+};
+
+// "TSPROG01", ca sa nu reluam dintr-un fisier care nu e de progres
+#define PROGRESS_MAGIC 0x3130474f52505354ull
+
+// antetul fisierului de progres, urmat de bitmap-ul chunk-urilor scrise deja in output
+struct progress_header {
+    uint64_t magic;
+    int nr_chunks;
+    int reserved;
+};
+
+// fisierul de output, prealocat si mapat in memorie; fiecare hash e scris la offset-ul lui final
+struct output_file {
+    int fd;
+    char* data; // nullptr pentru un fisier gol
+    size_t size;
+    // fisierul de progres, mapat si el: un bit setat = hash-ul chunk-ului e deja in output
+    int progress_fd;
+    progress_header* progress;
+    uint64_t* progress_words;
+    size_t progress_size;
+};
+
+// starea descarcarii unui fisier dorit
+struct file_download {
+    int status;          // DOWNLOAD_PENDING / DOWNLOAD_ACTIVE / DOWNLOAD_DONE
+    swarm_data swarm;    // swarm-ul cerut de la tracker pentru acest fisier
+    PiecePicker picker;  // ce chunk cerem si cine il are
+    output_file output;  // completat pe masura ce sosesc chunk-urile
+    int nr_responses;    // cate raspunsuri am primit (pentru update-urile periodice)
+    int poll_interval;   // la cate raspunsuri cerem update la swarm (adaptiv)
+    int next_poll;       // nr_responses la care urmeaza update-ul
+    vector<int> have_queue;   // peerii de la care vrem bitmap-ul "have"
+    vector<char> have_queued; // indexat dupa rank: e deja in coada sau cerut
+    int have_cursor;          // de unde continua rotatia prin peerii swarm-ului
+    vector<uint8_t> inflight; // cate cereri sunt in curs pentru fiecare chunk (in endgame pot fi mai multe)
 };
 
 class PeerManager {
@@ -18,31 +99,89 @@ public:
     int numtasks;
     int nr_files; // nr total file-uri, detinute + dorite
     int nr_owned_files;
+    // cererile/raspunsurile de chunk-uri circula separat de mesajele cu tracker-ul (MPI sau memorie partajata)
+    Transport* transport;
+    // mesajele cu tracker-ul (MPI_COMM_WORLD), trimise si ele prin motorul de progres
+    Transport* control;
+    // cu --comm-thread, thread-ul principal face apelurile MPI ale celorlalte (nullptr altfel)
+    ProgressEngine* engine;
+    // receive-ul mereu postat pentru notificarile tracker-elor (cu --push)
+    vector<char> push_buf;
+    xfer_request push_req;
 
     // datele despre fisierele detinute si dorite
-    file_data files[MAX_FILES];
-    int nr_owned_chunks[MAX_FILES];
+    vector<file_data> files;
+    vector<int> nr_owned_chunks;
+    // starea fiecarui chunk (CHUNK_MISSING / CHUNK_REQUESTED / CHUNK_OWNED)
+    vector<vector<char>> chunk_state;
+    // id-ul dat de tracker fiecarui fisier local (NOT_FOUND daca nu il are nimeni)
+    vector<int> file_ids;
+    // inversul: id tracker -> index in files (NOT_FOUND daca nu il avem/vrem)
+    vector<int> local_file_index;
+    // continutul fisierelor (chunk-urile unul dupa altul, vezi alloc_payload), nullptr fara --chunk-size
+    vector<char*> payloads;
+    // chunk-urile tuturor fisierelor, dupa continut; modificat doar de thread-ul de download, sub files_lock
+    ChunkStore store;
+    // protejeaza hash-urile si starea chunk-urilor, citite si din thread-ul de upload
+    pthread_mutex_t files_lock;
     
-    // Swarm-ul cerut de la tracker
-    swarm_data cur_swarm;
-    // Array in care tinem minte de cate ori am apelat la fiecare peer cu un chunk
-    int used_peer[MAX_CLIENTS];
-
-    int DEBUG_NR_HELPS;
+    // descarcarile in curs, indexate ca "files" (folosite doar pentru fisierele dorite)
+    vector<file_download> downloads;
+    // de la cine cerem chunk-urile (latenta, rata de succes si incarcarea fiecarei surse)
+    SourceSelector selector;
+    // pana cand (ns) nu mai cerem de la un peer care ne-a raspuns "choked"
+    vector<uint64_t> choked_until;
+    // cate chunk-uri am descarcat de la fiecare rank (pentru tit-for-tat), sub files_lock
+    vector<int> received_from;
+    // seed-urile stiute pentru fiecare fisier (de la tracker sau din PEX), anuntate in raspunsuri, sub files_lock
+    vector<vector<int>> known_seeds;
 
     PeerManager(int rank, int numtasks);
+    ~PeerManager();
 
     void read_input_file();
+    void alloc_payload(int file_index);
+    void free_payload(int file_index);
+    void generate_payload(int file_index);
+    char* chunk_payload(int file_index, int chunk_index);
 
-    // functii de initializare
-    void send_my_nr_files();
+    // functii de initializare (colective)
     void send_own_files_data();
+    void receive_file_ids();
 
-    void update_swarm(char* filename);
-    bool request_chunk(int rank_request, int file_index, int chunk_index);
-    void send_chunk(int rank_request);
-    int find_seed_for_chunk(); // returneaza rank-ul celui mai bun peer pentru un chunk (folosit cel mai putin)
-    void download_file_using_swarm(int file_index);
+    int tracker_for(int file_index);
+    void update_swarm(int file_index);
+    void apply_swarm_change(int file_index, const char* reply);
+    bool take_swarm_push();
+    bool receive_swarm_pushes();
+    bool wait_swarm_push(int timeout_ms);
+    void wait_push_end();
+    void start_download(int file_index);
+    void finish_download(int file_index);
+    void queue_have_requests(int file_index);
+    void publish_seeds(int file_index);
+    void add_gossip(int file_index, chunk_response& res);
+    void receive_gossip(inflight_request& slot);
+    void request_chunk(inflight_request& slot, xfer_request& recv_req, int rank_request, int file_index, int chunk_index);
+    void request_have(inflight_request& slot, xfer_request& recv_req, int rank_request, int file_index);
+    bool receive_chunk(inflight_request& slot, vector<inflight_request>& slots, bool digest_ok);
+    void redirect_payload(vector<inflight_request>& slots, int file_index, int chunk_index);
+    bool fetch_local(int file_index, int chunk_index);
+    void share_chunk(int file_index, int chunk_index);
+    bool verify_payload(int file_index, int chunk_index, const char* data, int len);
+    void receive_have(inflight_request& slot, int len);
+    const char* serve_chunk(const chunk_request& req, chunk_response& res);
+    void serve_have(const chunk_request& req, vector<uint64_t>& words);
+    // returneaza rank-ul celui mai bun detinator al chunk-ului, in afara celor din "exclude"
+    int find_seed_for_chunk(int file_index, int chunk_index, const vector<int>& exclude = vector<int>());
+    int pick_endgame_chunk(int file_index, const vector<inflight_request>& slots,
+                           const vector<xfer_request>& recv_reqs, int& source);
+    void download_wanted_files();
+    bool open_output_file(int index);
+    bool open_progress_file(int index, bool resume);
+    void resume_download(int file_index);
+    void verify_resumed_chunks(int file_index, const int* chunk_indices, int n, char* ok);
+    void write_output_chunk(int index, int chunk_index);
     void save_output_file(int index);
 };
 
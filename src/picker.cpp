@@ -0,0 +1,168 @@
+#include <algorithm>
+#include <cstdlib>
+#include <vector>
+#include "struct.h"
+#include "picker.h"
+
+using namespace std;
+
+void PiecePicker::init(int nr_chunks, int numtasks) {
+    this->nr_chunks = nr_chunks;
+    nr_seeds = 0;
+    words_per_rank = bitmap::words_for(nr_chunks);
+    have.assign((size_t)numtasks * words_per_rank, 0);
+    nr_holders.assign(nr_chunks, 0);
+    moved.assign(words_per_rank, 0);
+    chunks.resize(nr_chunks);
+
+    // la disponibilitate egala ordinea e aleatoare, ca peerii sa nu ceara aceleasi chunk-uri
+    order.resize(nr_chunks);
+    for (int c = 0; c < nr_chunks; c++) {
+        order[c] = c;
+    }
+    for (int i = nr_chunks - 1; i > 0; i--) {
+        swap(order[i], order[rand() % (i + 1)]);
+    }
+    for (int i = 0; i < nr_chunks; i++) {
+        chunks[order[i]] = {0, i};
+    }
+
+    // la inceput toate sunt in bucket-ul 0 (un chunk poate avea cel mult numtasks detinatori)
+    bucket_start.assign(numtasks + 2, nr_chunks);
+    bucket_start[0] = 0;
+}
+
+void PiecePicker::swap_positions(int a, int b) {
+    swap(order[a], order[b]);
+    chunks[order[a]].position = a;
+    chunks[order[b]].position = b;
+}
+
+// oricate "have" ar primi un chunk pana la alegere, e mutat o singura data
+void PiecePicker::add_holder(int chunk) {
+    nr_holders[chunk]++;
+    moved[chunk >> 6] |= (uint64_t)1 << (chunk & 63);
+}
+
+void PiecePicker::remove_holder(int chunk) {
+    nr_holders[chunk]--;
+    moved[chunk >> 6] |= (uint64_t)1 << (chunk & 63);
+}
+
+/* muta chunk-urile marcate in bucket-ul dat de nr. lor de detinatori: in sus, prin
+interschimbare cu ultimul din bucket (care devine primul din urmatorul), in jos invers */
+void PiecePicker::flush() {
+    for (int w = 0; w < (int)moved.size(); w++) {
+        for (uint64_t bits = moved[w]; bits; bits &= bits - 1) {
+            int c = w * 64 + __builtin_ctzll(bits);
+            chunk_info& info = chunks[c];
+            if (info.bucket < 0) {
+                continue;
+            }
+            while (info.bucket < nr_holders[c]) {
+                swap_positions(info.position, --bucket_start[++info.bucket]);
+            }
+            while (info.bucket > nr_holders[c]) {
+                swap_positions(info.position, bucket_start[info.bucket--]++);
+            }
+        }
+        moved[w] = 0;
+    }
+}
+
+// un chunk detinut coboara prin toate bucket-urile de sub el pana in prefixul celor detinute
+void PiecePicker::retire(int chunk) {
+    chunk_info& info = chunks[chunk];
+    for (int k = info.bucket; k >= 0; k--) {
+        swap_positions(info.position, bucket_start[k]++);
+    }
+    info.bucket = -1;
+}
+
+// seed-urile au tot fisierul, asa ca bitmap-urile celor deveniti seed nu mai conteaza
+void PiecePicker::update_seeds(const swarm_update& owners) {
+    int seeds = 0;
+    int nr_ranks = words_per_rank > 0 ? have.size() / words_per_rank : 0;
+
+    for (int r = 0; r < nr_ranks; r++) {
+        if (!owners.is_seed.test(r)) {
+            continue;
+        }
+        seeds++;
+
+        uint64_t* known = &have[(size_t)r * words_per_rank];
+        for (int w = 0; w < words_per_rank; w++) {
+            for (uint64_t bits = known[w]; bits; bits &= bits - 1) {
+                remove_holder(w * 64 + __builtin_ctzll(bits));
+            }
+            known[w] = 0;
+        }
+    }
+    nr_seeds = seeds;
+}
+
+// bitmap-ul primit de la un peer; chunk-urile nu se pierd, deci doar se adauga biti
+void PiecePicker::update_have(int rank, const uint64_t* words, int nr_words) {
+    uint64_t* known = &have[(size_t)rank * words_per_rank];
+
+    nr_words = min(nr_words, words_per_rank);
+    for (int w = 0; w < nr_words; w++) {
+        // bitii de dupa ultimul chunk nu se pastreaza
+        uint64_t added = words[w] & ~known[w];
+        if (w == words_per_rank - 1 && nr_chunks % 64 != 0) {
+            added &= ((uint64_t)1 << (nr_chunks % 64)) - 1;
+        }
+        if (added == 0) {
+            continue;
+        }
+
+        known[w] |= added;
+        while (added) {
+            add_holder(w * 64 + __builtin_ctzll(added));
+            added &= added - 1;
+        }
+    }
+}
+
+// un singur chunk nou anuntat de un peer (mesajul "have" din simulare)
+void PiecePicker::add_have(int rank, int chunk) {
+    uint64_t& word = have[(size_t)rank * words_per_rank + (chunk >> 6)];
+    uint64_t bit = (uint64_t)1 << (chunk & 63);
+    if (word & bit) {
+        return;
+    }
+
+    word |= bit;
+    add_holder(chunk);
+}
+
+// stim sigur ca "rank" are chunk-ul (e seed sau l-a anuntat)
+bool PiecePicker::holds(const swarm_update& owners, int rank, int chunk) const {
+    if (owners.is_seed.test(rank)) {
+        return true;
+    }
+    return (have[(size_t)rank * words_per_rank + (chunk >> 6)] >> (chunk & 63)) & 1;
+}
+
+/* urmatorul chunk lipsa, cel mai rar intai, sau NOT_FOUND daca nu avem ce cere. Fara seed-uri,
+bucket-ul 0 (chunk-uri pe care nu le are nimeni) e sarit; in rest se trece doar peste chunk-urile
+deja cerute (cel mult cat fereastra), cele detinute fiind scoase definitiv */
+int PiecePicker::next_chunk(const vector<char>& chunk_state) {
+    flush();
+    int pos = bucket_start[nr_seeds > 0 ? 0 : 1];
+
+    while (pos < nr_chunks) {
+        int c = order[pos];
+        if (chunk_state[c] == CHUNK_MISSING) {
+            return c;
+        }
+        if (chunk_state[c] == CHUNK_OWNED) {
+            // pe pozitia lui ajunge un chunk din acelasi bucket, deci o verificam din nou
+            retire(c);
+            pos = max(pos, bucket_start[0]);
+        } else {
+            pos++;
+        }
+    }
+    return NOT_FOUND;
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <stdint.h>
+#include <vector>
+#include "struct.h"
+
+/* alege urmatorul chunk de cerut pentru un fisier: cel mai rar (rarest-first) dintre cele
+inca lipsa, tinand cont de ce chunk-uri au anuntat peerii (bitmap-urile "have").
+
+Chunk-urile stau in "order" grupate dupa cati peeri le au (bucket-ul k incepe la
+bucket_start[k]), in ordine aleatoare in cadrul unui bucket. Un "have" nou doar numara
+detinatorul si marcheaza chunk-ul in "moved" (doi vectori mici, singurii atinsi la fiecare
+anunt); la urmatoarea alegere fiecare chunk marcat urca in bucket-ul corect cu cate o
+interschimbare pe bucket (cu ultimul din bucket-ul lui), deci ordinea nu se reface niciodata
+de la zero. Chunk-urile detinute sunt scoase, la prima intalnire, intr-un prefix inaintea
+bucket-ului 0. Bitmap-urile tuturor peerilor sunt intr-un singur vector, ca verificarea
+detinatorilor unui chunk sa citeasca memorie contigua */
+class PiecePicker {
+public:
+    int nr_chunks;
+    int nr_seeds;
+
+    void init(int nr_chunks, int numtasks);
+    void update_seeds(const swarm_update& owners);
+    void update_have(int rank, const uint64_t* words, int nr_words);
+    void add_have(int rank, int chunk);
+    // doar numara un detinator nou, pentru cine stie singur cine ce are (simularea)
+    void add_holder(int chunk);
+    // aduce in cache ce modifica add_holder, ca mai multe picker-e sa poata fi actualizate deodata
+    void prefetch_holder(int chunk) const {
+        __builtin_prefetch(&nr_holders[chunk], 1);
+        __builtin_prefetch(&moved[chunk >> 6], 1);
+    }
+    bool holds(const swarm_update& owners, int rank, int chunk) const;
+    int next_chunk(const std::vector<char>& chunk_state);
+
+    // cati peeri (fara seed-uri) au chunk-ul
+    int holders(int chunk) const {
+        return nr_holders[chunk];
+    }
+
+private:
+    struct chunk_info {
+        int bucket;   // bucket-ul in care sta acum (ramane in urma lui nr_holders pana la flush), -1 = detinut
+        int position; // in order
+    };
+
+    // ce atinge add_holder e primul, langa nr_chunks
+    std::vector<int> nr_holders;
+    std::vector<uint64_t> moved;     // chunk-urile al caror nr. de detinatori s-a schimbat de la ultima alegere
+    int words_per_rank;
+    std::vector<uint64_t> have;      // bitmap-ul rank-ului r incepe la r * words_per_rank, gol daca nu stim ce are
+    std::vector<chunk_info> chunks;
+    std::vector<int> order;          // chunk-urile, de la cel mai rar la cel mai comun
+    std::vector<int> bucket_start;   // indexat dupa nr. de detinatori; inainte de bucket_start[0] sunt cele detinute
+
+    void swap_positions(int a, int b);
+    void remove_holder(int chunk);
+    void flush();
+    void retire(int chunk);
+};
@@ -0,0 +1,415 @@
+#include <mpi.h>
+#include <sched.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+#include <time.h>
+#include <atomic>
+#include <cstring>
+#include <vector>
+#include <algorithm>
+#include "struct.h"
+#include "progress.h"
+
+using namespace std;
+
+// indexul cozii thread-ului curent (dat de attach)
+static thread_local int engine_worker = NOT_FOUND;
+
+// futex intre thread-urile aceluiasi proces
+static void futex_wait(atomic<uint32_t>* word, uint32_t value, long timeout_ns) {
+    timespec timeout = {0, timeout_ns};
+    syscall(SYS_futex, reinterpret_cast<uint32_t*>(word), FUTEX_WAIT_PRIVATE, value, &timeout, nullptr, 0);
+}
+
+static void futex_wake(atomic<uint32_t>* word) {
+    syscall(SYS_futex, reinterpret_cast<uint32_t*>(word), FUTEX_WAKE_PRIVATE, 1, nullptr, nullptr, 0);
+}
+
+/* "sleeping" e scris inaintea ultimei verificari a lui wake_seq, iar cel care trezeste il
+citeste dupa ce a incrementat wake_seq, deci cel putin unul dintre ei vede schimbarea */
+static void sleep_on(atomic<uint32_t>& wake_seq, atomic<uint32_t>& sleeping, uint32_t seq, long timeout_ns) {
+    sleeping.store(1, memory_order_seq_cst);
+    if (wake_seq.load(memory_order_seq_cst) == seq) {
+        futex_wait(&wake_seq, seq, timeout_ns);
+    }
+    sleeping.store(0, memory_order_relaxed);
+}
+
+static void wake(atomic<uint32_t>& wake_seq, atomic<uint32_t>& sleeping) {
+    wake_seq.fetch_add(1, memory_order_seq_cst);
+    if (sleeping.load(memory_order_seq_cst)) {
+        futex_wake(&wake_seq);
+    }
+}
+
+ProgressEngine::ProgressEngine() : nr_attached(0), nr_detached(0), wake_seq(0), sleeping(0) {
+    for (int w = 0; w < ENGINE_MAX_WORKERS; w++) {
+        queues[w].head.store(0);
+        queues[w].tail.store(0);
+        waiters[w].wake_seq.store(0);
+        waiters[w].sleeping.store(0);
+    }
+}
+
+void ProgressEngine::attach() {
+    engine_worker = nr_attached.fetch_add(1);
+}
+
+// thread-ul nu mai are operatii in curs, deci dupa ultima lui comanda motorul se poate opri
+void ProgressEngine::detach() {
+    nr_detached.fetch_add(1, memory_order_release);
+    engine_worker = NOT_FOUND;
+    wake(wake_seq, sleeping);
+}
+
+// cat timp coada e plina, motorul e in urma; il lasam sa o goleasca
+void ProgressEngine::submit(int type, MPI_Comm comm, xfer_request* req) {
+    engine_queue& q = queues[engine_worker];
+    uint64_t tail = q.tail.load(memory_order_relaxed);
+
+    while (tail - q.head.load(memory_order_acquire) >= ENGINE_QUEUE_SIZE) {
+        wake(wake_seq, sleeping);
+        sched_yield();
+    }
+
+    q.commands[tail % ENGINE_QUEUE_SIZE] = {type, comm, req};
+    q.tail.store(tail + 1, memory_order_release);
+    wake(wake_seq, sleeping);
+}
+
+uint32_t ProgressEngine::completion_seq() {
+    return waiters[engine_worker].wake_seq.load(memory_order_acquire);
+}
+
+/* intai cateva verificari cedand procesorul, apoi pe futex pana la urmatoarea operatie terminata
+(sau cel mult "timeout_ns", sub o secunda) */
+void ProgressEngine::wait_completion(uint32_t seq, long timeout_ns) {
+    engine_waiter& w = waiters[engine_worker];
+
+    for (int i = 0; i < ENGINE_SPIN; i++) {
+        if (w.wake_seq.load(memory_order_acquire) != seq) {
+            return;
+        }
+        sched_yield();
+    }
+    sleep_on(w.wake_seq, w.sleeping, seq, timeout_ns);
+}
+
+// marcheaza operatia (DONE, sau NULL dupa anulare) si trezeste thread-ul care o asteapta
+void ProgressEngine::complete(const engine_op& op, int source, int count, int state) {
+    op.req->status.source = source;
+    op.req->status.count = count;
+    op.req->store_state(state);
+
+    engine_waiter& w = waiters[op.worker];
+    wake(w.wake_seq, w.sleeping);
+}
+
+void ProgressEngine::execute(int worker, const engine_command& cmd) {
+    xfer_request* req = cmd.req;
+    engine_op op = {cmd.type, worker, cmd.comm, req};
+    int source = req->source == XFER_ANY_SOURCE ? MPI_ANY_SOURCE : req->source;
+    MPI_Request handle;
+
+    switch (cmd.type) {
+    case ENGINE_ISEND:
+        MPI_Isend(req->buf, req->len, MPI_BYTE, req->source, req->tag, cmd.comm, &handle);
+        break;
+    case ENGINE_IRECV:
+        MPI_Irecv(req->buf, req->len, MPI_BYTE, source, req->tag, cmd.comm, &handle);
+        break;
+    case ENGINE_IRECV_PACKED:
+        probes.push_back(op);
+        return;
+    default: {
+        /* anularea: operatia poate fi inca in curs, in asteptarea probe-ului sau deja terminata
+        (atunci mesajul primit se pierde, ca la un MPI_Cancel care ajunge prea tarziu). Sursa
+        raportata e XFER_ANY_SOURCE doar daca niciun mesaj nu a fost primit */
+        MPI_Status status;
+        int cancelled = 0;
+        status.MPI_SOURCE = req->status.source;
+        for (size_t i = 0; i < active.size(); i++) {
+            if (active[i].req == req) {
+                MPI_Cancel(&handles[i]);
+                MPI_Wait(&handles[i], &status);
+                MPI_Test_cancelled(&status, &cancelled);
+                active[i] = active.back();
+                handles[i] = handles.back();
+                active.pop_back();
+                handles.pop_back();
+                break;
+            }
+        }
+        size_t nr_probes = probes.size();
+        probes.erase(remove_if(probes.begin(), probes.end(), [&](const engine_op& p) {
+            return p.req == req;
+        }), probes.end());
+        if (probes.size() != nr_probes) {
+            cancelled = 1;
+        }
+        complete(op, cancelled ? XFER_ANY_SOURCE : status.MPI_SOURCE, 0, XFER_NULL);
+        return;
+    }
+    }
+
+    active.push_back(op);
+    handles.push_back(handle);
+}
+
+bool ProgressEngine::drain(int worker) {
+    engine_queue& q = queues[worker];
+    uint64_t head = q.head.load(memory_order_relaxed);
+    uint64_t tail = q.tail.load(memory_order_acquire);
+
+    for (uint64_t i = head; i < tail; i++) {
+        execute(worker, q.commands[i % ENGINE_QUEUE_SIZE]);
+    }
+    q.head.store(tail, memory_order_release);
+    return tail != head;
+}
+
+bool ProgressEngine::poll() {
+    bool progressed = false;
+
+    // un receive de dimensiune necunoscuta devine unul obisnuit cand i-a sosit mesajul
+    for (size_t i = 0; i < probes.size(); i++) {
+        engine_op& op = probes[i];
+        int source = op.req->source == XFER_ANY_SOURCE ? MPI_ANY_SOURCE : op.req->source;
+        int flag, len;
+        MPI_Message msg;
+        MPI_Status status;
+        MPI_Request handle;
+
+        MPI_Improbe(source, op.req->tag, op.comm, &flag, &msg, &status);
+        if (!flag) {
+            continue;
+        }
+        MPI_Get_count(&status, MPI_BYTE, &len);
+        op.req->packed->resize(len);
+        MPI_Imrecv(op.req->packed->data(), len, MPI_BYTE, &msg, &handle);
+
+        active.push_back(op);
+        handles.push_back(handle);
+        probes[i--] = probes.back();
+        probes.pop_back();
+        progressed = true;
+    }
+
+    if (active.empty()) {
+        return progressed;
+    }
+
+    int nr_done;
+    indices.resize(active.size());
+    statuses.resize(active.size());
+    MPI_Testsome(active.size(), handles.data(), &nr_done, indices.data(), statuses.data());
+    if (nr_done == MPI_UNDEFINED || nr_done == 0) {
+        return progressed;
+    }
+
+    for (int d = 0; d < nr_done; d++) {
+        int count;
+        MPI_Get_count(&statuses[d], MPI_BYTE, &count);
+        engine_op& op = active[indices[d]];
+        if (op.type == ENGINE_IRECV_PACKED) {
+            op.req->packed = nullptr;
+        }
+        complete(op, statuses[d].MPI_SOURCE, count, XFER_DONE);
+    }
+
+    // scoatem operatiile terminate de la coada spre inceput, ca indicii ramasi sa fie valizi
+    sort(indices.begin(), indices.begin() + nr_done, greater<int>());
+    for (int d = 0; d < nr_done; d++) {
+        int i = indices[d];
+        active[i] = active.back();
+        handles[i] = handles.back();
+        active.pop_back();
+        handles.pop_back();
+    }
+    return true;
+}
+
+/* un mesaj MPI sosit nu poate trezi motorul, deci cat are operatii in curs le verifica fara
+pauze, cedand procesorul intre ture (cum face si MPI_Wait); un somn oricat de scurt ar intarzia
+fiecare raspuns. Fara nicio operatie in curs, doar o comanda noua ii poate da de lucru: dupa
+ENGINE_SPIN ture doarme pe futex, iar submit il trezeste. Se opreste dupa ce s-au detasat toate
+thread-urile si le-a golit cozile */
+void ProgressEngine::run(int nr_workers) {
+    int idle = 0;
+
+    while (true) {
+        uint32_t seq = wake_seq.load(memory_order_acquire);
+        bool done = nr_detached.load(memory_order_acquire) == nr_workers;
+
+        bool progressed = false;
+        for (int w = 0; w < ENGINE_MAX_WORKERS; w++) {
+            progressed |= drain(w);
+        }
+        progressed |= poll();
+
+        if (progressed) {
+            idle = 0;
+            continue;
+        }
+        if (done) {
+            return;
+        }
+
+        if (!active.empty() || !probes.empty() || ++idle < ENGINE_SPIN) {
+            sched_yield();
+        } else {
+            sleep_on(wake_seq, sleeping, seq, ENGINE_WAIT_NS);
+        }
+    }
+}
+
+ProxyTransport::ProxyTransport(ProgressEngine* engine, MpiTransport* inner)
+    : engine(engine), inner(inner), comm(inner->communicator()) {}
+
+ProxyTransport::~ProxyTransport() {
+    delete inner;
+}
+
+// parametrii se scriu inaintea comenzii, motorul ii citeste dupa ce o preia din coada
+void ProxyTransport::post(int type, xfer_request& req) {
+    req.store_state(XFER_ACTIVE);
+    engine->submit(type, comm, &req);
+}
+
+void ProxyTransport::isend(const void* buf, int len, int dest, int tag, xfer_request& req) {
+    req.buf = const_cast<void*>(buf);
+    req.len = len;
+    req.source = dest;
+    req.tag = tag;
+    req.persistent = false;
+    post(ENGINE_ISEND, req);
+}
+
+void ProxyTransport::send(const void* buf, int len, int dest, int tag) {
+    xfer_request req;
+    isend(buf, len, dest, tag, req);
+    wait(req, nullptr);
+}
+
+void ProxyTransport::irecv(void* buf, int len, int source, int tag, xfer_request& req) {
+    req.buf = buf;
+    req.len = len;
+    req.source = source;
+    req.tag = tag;
+    req.persistent = false;
+    post(ENGINE_IRECV, req);
+}
+
+void ProxyTransport::irecv_packed(vector<char>& buf, int source, int tag, xfer_request& req) {
+    req.packed = &buf;
+    req.source = source;
+    req.tag = tag;
+    req.persistent = false;
+    post(ENGINE_IRECV_PACKED, req);
+}
+
+// un receive persistent e repornit de motor ca unul obisnuit, cu aceiasi parametri
+void ProxyTransport::recv_init(void* buf, int len, int source, int tag, xfer_request& req) {
+    req.buf = buf;
+    req.len = len;
+    req.source = source;
+    req.tag = tag;
+    req.persistent = true;
+    req.store_state(XFER_INACTIVE);
+}
+
+void ProxyTransport::start(xfer_request& req) {
+    post(ENGINE_IRECV, req);
+}
+
+// motorul raporteaza anularea reusita prin sursa XFER_ANY_SOURCE (vezi ProgressEngine::execute)
+bool ProxyTransport::cancel(xfer_request& req) {
+    bool cancelled = false;
+    if (req.load_state() == XFER_ACTIVE) {
+        engine->submit(ENGINE_CANCEL, comm, &req);
+        while (true) {
+            uint32_t seq = engine->completion_seq();
+            if (req.load_state() == XFER_NULL) {
+                break;
+            }
+            engine->wait_completion(seq);
+        }
+        cancelled = req.status.source == XFER_ANY_SOURCE;
+    }
+    req.packed = nullptr;
+    req.persistent = false;
+    req.store_state(XFER_NULL);
+    return cancelled;
+}
+
+bool ProxyTransport::test(xfer_request& req, xfer_status* status) {
+    if (req.load_state() != XFER_DONE) {
+        return false;
+    }
+    if (status != nullptr) {
+        *status = req.status;
+    }
+    req.store_state(req.persistent ? XFER_INACTIVE : XFER_NULL);
+    return true;
+}
+
+void ProxyTransport::wait(xfer_request& req, xfer_status* status) {
+    if (!req.active()) {
+        if (status != nullptr) {
+            *status = {XFER_ANY_SOURCE, 0};
+        }
+        return;
+    }
+
+    while (true) {
+        uint32_t seq = engine->completion_seq();
+        if (test(req, status)) {
+            return;
+        }
+        engine->wait_completion(seq);
+    }
+}
+
+// doarme pe futex-ul thread-ului, trezit de motor cand termina una dintre operatiile lui
+bool ProxyTransport::wait_for(xfer_request& req, int timeout_ms, xfer_status* status) {
+    uint64_t deadline_ns = xfer_now_ns() + (uint64_t)timeout_ms * 1000000;
+
+    while (true) {
+        uint32_t seq = engine->completion_seq();
+        if (test(req, status)) {
+            return true;
+        }
+        uint64_t now_ns = xfer_now_ns();
+        if (!req.active() || now_ns >= deadline_ns) {
+            return false;
+        }
+        engine->wait_completion(seq, min(deadline_ns - now_ns, (uint64_t)ENGINE_WAIT_NS));
+    }
+}
+
+void ProxyTransport::waitsome(int n, xfer_request* reqs, int& nr_done, int* indices, xfer_status* statuses) {
+    while (true) {
+        uint32_t seq = engine->completion_seq();
+        bool any_active = false;
+
+        nr_done = 0;
+        for (int i = 0; i < n; i++) {
+            any_active |= reqs[i].active();
+            if (test(reqs[i], &statuses[nr_done])) {
+                indices[nr_done++] = i;
+            }
+        }
+        if (nr_done > 0 || !any_active) {
+            return;
+        }
+        engine->wait_completion(seq);
+    }
+}
+
+Transport* funnel_transport(ProgressEngine* engine, Transport* t) {
+    if (engine == nullptr || strcmp(t->name(), "mpi") != 0) {
+        return t;
+    }
+    return new ProxyTransport(engine, static_cast<MpiTransport*>(t));
+}
@@ -0,0 +1,127 @@
+#pragma once
+
+#include <mpi.h>
+#include <stdint.h>
+#include <atomic>
+#include <vector>
+#include "transport.h"
+
+/* cu --comm-thread (implicit), MPI e initializat cu MPI_THREAD_FUNNELED: la un peer doar thread-ul
+principal apeleaza MPI, iar thread-urile de download si upload ii predau operatiile prin cate o
+coada fara lock-uri (un producator, un consumator). Thread-ul principal devine motorul de
+progres: porneste operatiile, le urmareste cu MPI_Testsome si marcheaza request-urile terminate,
+pe care thread-ul care le-a cerut le vede in xfer_request.state. Transportul shm nu are nevoie
+de MPI, deci cererile de chunk-uri trec pe langa motor */
+
+#define ENGINE_MAX_WORKERS 2
+// cate comenzi nepreluate poate avea un thread (mai multe il fac sa astepte motorul)
+#define ENGINE_QUEUE_SIZE 1024
+/* cate ture fara nimic de facut cedeaza procesorul motorul fara operatii in curs (o comanda noua
+il trezeste de pe futex) sau un thread care asteapta o operatie, inainte sa adoarma */
+#define ENGINE_SPIN 64
+// cat doarme cel mult motorul sau un thread, ca plasa de siguranta pentru o trezire pierduta
+#define ENGINE_WAIT_NS 10000000
+
+// operatiile predate motorului (parametrii lor sunt in xfer_request)
+#define ENGINE_ISEND        0
+#define ENGINE_IRECV        1
+#define ENGINE_IRECV_PACKED 2
+#define ENGINE_CANCEL       3
+
+struct engine_command {
+    int type;
+    MPI_Comm comm;
+    xfer_request* req;
+};
+
+// coada unui thread: doar el scrie "tail", doar motorul scrie "head"
+struct engine_queue {
+    alignas(64) std::atomic<uint64_t> head;
+    alignas(64) std::atomic<uint64_t> tail;
+    engine_command commands[ENGINE_QUEUE_SIZE];
+};
+
+// cuvantul futex pe care doarme un thread care asteapta terminarea unei operatii
+struct engine_waiter {
+    alignas(64) std::atomic<uint32_t> wake_seq;
+    std::atomic<uint32_t> sleeping;
+};
+
+// o operatie pornita de motor
+struct engine_op {
+    int type;
+    int worker;
+    MPI_Comm comm;
+    xfer_request* req;
+};
+
+class ProgressEngine {
+public:
+    ProgressEngine();
+
+    // apelate de thread-urile care predau operatii, la inceputul si la sfarsitul lor
+    void attach();
+    void detach();
+    void submit(int type, MPI_Comm comm, xfer_request* req);
+    // asteapta o operatie terminata (seq e citit inaintea verificarii, vezi ProxyTransport)
+    uint32_t completion_seq();
+    void wait_completion(uint32_t seq, long timeout_ns = ENGINE_WAIT_NS);
+
+    // bucla thread-ului principal, pana se detaseaza "nr_workers" thread-uri
+    void run(int nr_workers);
+
+private:
+    engine_queue queues[ENGINE_MAX_WORKERS];
+    engine_waiter waiters[ENGINE_MAX_WORKERS];
+    std::atomic<int> nr_attached;
+    std::atomic<int> nr_detached;
+    // trezirea motorului la o comanda noua
+    alignas(64) std::atomic<uint32_t> wake_seq;
+    std::atomic<uint32_t> sleeping;
+
+    // doar ale thread-ului principal: operatiile in curs si, in paralel, request-urile MPI ale lor
+    std::vector<engine_op> active;
+    std::vector<MPI_Request> handles;
+    std::vector<engine_op> probes; // receive-uri de dimensiune necunoscuta, inca nesosite
+    std::vector<int> indices;
+    std::vector<MPI_Status> statuses;
+
+    bool drain(int worker);
+    void execute(int worker, const engine_command& cmd);
+    bool poll();
+    void complete(const engine_op& op, int source, int count, int state);
+};
+
+/* transportul MPI vazut de thread-urile de download si upload: fiecare operatie e predata
+motorului, iar wait/test/waitsome doar urmaresc starea request-urilor */
+class ProxyTransport : public Transport {
+public:
+    ProxyTransport(ProgressEngine* engine, MpiTransport* inner);
+    ~ProxyTransport();
+    const char* name() const {
+        return inner->name();
+    }
+
+    void isend(const void* buf, int len, int dest, int tag, xfer_request& req);
+    void send(const void* buf, int len, int dest, int tag);
+    void irecv(void* buf, int len, int source, int tag, xfer_request& req);
+    void irecv_packed(std::vector<char>& buf, int source, int tag, xfer_request& req);
+    void recv_init(void* buf, int len, int source, int tag, xfer_request& req);
+    void start(xfer_request& req);
+    bool cancel(xfer_request& req);
+    void wait(xfer_request& req, xfer_status* status);
+    bool wait_for(xfer_request& req, int timeout_ms, xfer_status* status);
+    bool test(xfer_request& req, xfer_status* status);
+    void waitsome(int n, xfer_request* reqs, int& nr_done, int* indices, xfer_status* statuses);
+
+private:
+    ProgressEngine* engine;
+    MpiTransport* inner;
+    MPI_Comm comm;
+
+    void post(int type, xfer_request& req);
+};
+
+/* transportul prin care trec operatiile unui thread de download/upload: cel MPI e inlocuit cu
+un ProxyTransport peste motor (care il preia), restul raman neschimbate; fara motor, "t" */
+Transport* funnel_transport(ProgressEngine* engine, Transport* t);
@@ -0,0 +1,33 @@
+#include <algorithm>
+#include <vector>
+#include "struct.h"
+#include "selector.h"
+
+using namespace std;
+
+void SourceSelector::init(int numtasks, bool adaptive) {
+    this->adaptive = adaptive;
+    sources.assign(numtasks, source_stats{0, 1, 0, 0});
+}
+
+void SourceSelector::on_request(int rank) {
+    sources[rank].inflight++;
+    sources[rank].used++;
+}
+
+void SourceSelector::on_response(int rank, uint64_t latency_ns, bool ok) {
+    source_stats& s = sources[rank];
+
+    s.inflight--;
+    s.latency_ns = s.latency_ns == 0 ? latency_ns : (1 - SELECTOR_EWMA_ALPHA) * s.latency_ns
+                                                     + SELECTOR_EWMA_ALPHA * latency_ns;
+    s.ok_rate = (1 - SELECTOR_EWMA_ALPHA) * s.ok_rate + SELECTOR_EWMA_ALPHA * (ok ? 1 : 0);
+}
+
+/* cat ar dura, estimat, sa primim un chunk bun de la sursa: fiecare cerere din fata noastra
+costa o latenta, iar un raspuns esuat inseamna o cerere repetata. O sursa fara masuratori are
+estimarea 0, deci e incercata repede */
+double SourceSelector::expected_service_ns(int rank) const {
+    const source_stats& s = sources[rank];
+    return s.latency_ns * (1 + s.inflight) / max(s.ok_rate, SELECTOR_MIN_OK_RATE);
+}
@@ -0,0 +1,87 @@
+#pragma once
+
+#include <stdint.h>
+#include <cstdlib>
+#include <vector>
+#include "struct.h"
+
+// ce stim despre o sursa (rank) din cererile trimise catre ea
+struct source_stats {
+    double latency_ns; // EWMA a timpului de raspuns, 0 daca nu avem inca masuratori
+    double ok_rate;    // EWMA a raspunsurilor bune (1 = toate)
+    int inflight;      // cereri trimise si fara raspuns
+    int used;          // cate cereri i-am trimis (euristica veche)
+};
+
+/* alege de la cine cerem un chunk, dintre detinatorii lui. Implicit (adaptiv): doua surse
+aleatoare (power of two choices), castiga cea cu timpul asteptat de servire mai mic (latenta
+EWMA inmultita cu cererile in curs, impartita la rata de succes), asa ca sursele lente sau
+ocupate sunt evitate de la sine. Cu "--selector legacy": euristica veche, de la un index
+aleator se aleg FIND_NUM_TRIES detinatori si castiga cel folosit de cele mai putine ori */
+class SourceSelector {
+public:
+    bool adaptive;
+    std::vector<source_stats> sources; // indexat dupa rank
+
+    void init(int numtasks, bool adaptive);
+    void on_request(int rank);
+    void on_response(int rank, uint64_t latency_ns, bool ok);
+    double expected_service_ns(int rank) const;
+
+    // "eligible(rank)" spune daca rank-ul are chunk-ul si putem cere de la el
+    template <class F> int pick(F eligible);
+
+private:
+    template <class F> int pick_legacy(F eligible);
+    template <class F> int pick_two_choices(F eligible);
+};
+
+// alegerea se numara abia cand cererea e trimisa (on_request), nu orice candidat e si folosit
+template <class F> int SourceSelector::pick(F eligible) {
+    return adaptive ? pick_two_choices(eligible) : pick_legacy(eligible);
+}
+
+template <class F> int SourceSelector::pick_legacy(F eligible) {
+    int numtasks = sources.size();
+    int best = NOT_FOUND;
+    int best_usage = BIG_VALUE;
+    int start_index = rand() % numtasks;
+    int nr_tries = 0;
+
+    for (int offset = 0; offset < numtasks && nr_tries < FIND_NUM_TRIES; offset++) {
+        int i = (start_index + offset) % numtasks;
+        if (eligible(i) && sources[i].used < best_usage) {
+            best = i;
+            best_usage = sources[i].used;
+            nr_tries++;
+        }
+    }
+    return best;
+}
+
+// doi candidati uniform aleatori dintre cei eligibili (reservoir sampling), intr-o singura trecere
+template <class F> int SourceSelector::pick_two_choices(F eligible) {
+    int numtasks = sources.size();
+    int first = NOT_FOUND, second = NOT_FOUND;
+    int nr_seen = 0;
+
+    for (int i = 0; i < numtasks; i++) {
+        if (!eligible(i)) {
+            continue;
+        }
+
+        nr_seen++;
+        if (nr_seen == 1) {
+            first = i;
+        } else if (nr_seen == 2) {
+            second = i;
+        } else if (rand() % nr_seen < 2) {
+            (rand() & 1 ? first : second) = i;
+        }
+    }
+
+    if (second == NOT_FOUND || expected_service_ns(first) <= expected_service_ns(second)) {
+        return first;
+    }
+    return second;
+}
@@ -0,0 +1,13 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+#define SHA256_SIZE 32
+
+// rezumatul SHA-256 al continutului unui chunk (modul cu payload)
+struct sha256_digest {
+    uint8_t bytes[SHA256_SIZE];
+};
+
+void sha256(const void* data, size_t len, sha256_digest& out);
@@ -0,0 +1,673 @@
+#include <malloc.h>
+#include <sys/mman.h>
+#include <time.h>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <vector>
+#include <algorithm>
+#include "struct.h"
+#include "picker.h"
+#include "selector.h"
+#include "choker.h"
+#include "sim_queue.h"
+
+using namespace std;
+
+// cata memorie ocupa un nod virtual (estimare, cu rezerva) si marimea unei huge page
+#define SIM_BYTES_PER_PEER 8192
+#define HUGE_PAGE_SIZE (2 << 20)
+
+/* simulare cu evenimente discrete, intr-un singur proces, a unui swarm de dimensiuni pe care
+MPI nu le poate rula pe o masina (implicit 50000 de peeri; pana pe la atatia simularea merge mai
+repede decat timpul real, la 100000 nu mai incape in cache, vezi README). Fiecare peer e un nod virtual cu
+aceleasi politici ca peer.cpp: PiecePicker (rarest-first), SourceSelector (adaptiv sau legacy)
+si UploadScheduler (tit-for-tat), iar timpul e simulat: o cerere ajunge dupa latenta legaturii,
+iar un chunk ocupa upload-ul sursei chunk_size / bandwidth, deci cererile la aceeasi sursa
+asteapta una dupa alta.
+
+Ca memoria sa nu creasca cu patratul nr. de peeri, fiecare nod are doar vecinii primiti de la
+tracker (ca in BitTorrent), iar politicile lucreaza cu indexul vecinului in lista. Anunturile
+"have" ajung instantaneu la vecini.
+
+Tracker-ul e si el un nod virtual, cu protocolul lui TrackerManager pentru un fisier: la intrare
+nodul cere swarm-ul (primeste cel mult --neighbors peeri aleatori), cel cu prea putini vecini
+cere update-uri, iar la final trimite MSG_FILE_DONE. Cine a primit prea putini peeri la intrare
+devine abonat: intrarile noi ii sunt trimise in notificari adunate la PUSH_INTERVAL_MS, pana are
+destui ("--push 0" lasa doar update-urile). Fiecare mesaj primit sau trimis ii ocupa
+tracker-ului "--tracker-us", deci mesajele lui asteapta unul dupa altul, ca upload-ul unui nod.
+
+    make sim && ./sim [--peers N] [--seeds S] [--chunks C] [--chunk-size B] [--neighbors K]
+        [--window W] [--upload-slots U] [--latency-us L] [--bandwidth MBPS] [--slow-pct P]
+        [--arrival-ms A] [--tracker-us T] [--push 0|1] [--selector adaptive|legacy]
+        [--picker rarest|random] [--seed X] */
+
+struct sim_params {
+    int nr_peers;
+    int nr_seeds;
+    int nr_chunks;
+    int chunk_size;     // octeti
+    int nr_neighbors;   // cati vecini cere un nod la intrare (accepta pana la dublu)
+    int window;
+    int upload_slots;
+    int latency_us;     // latenta unei legaturi, intr-un sens
+    int bandwidth_mbps; // upload-ul unui nod
+    int slow_pct;       // procentul de noduri cu upload de 10 ori mai mic
+    int arrival_ms;     // leecher-ii intra uniform in [0, arrival_ms]
+    int tracker_us;     // cat ii ia tracker-ului un mesaj
+    int push;           // tracker-ul anunta peerii noi abonatilor
+    int max_sim_s;      // limita timpului simulat
+    int seed;
+    const char* selector;
+    const char* picker;
+};
+
+static sim_params params = {50000, 10, 100, 262144, 20, DOWNLOAD_WINDOW, UPLOAD_SLOTS, 50000, 20, 0, 1000,
+                            5, 1, 3600, 1, "adaptive", "rarest"};
+
+enum sim_event_type {
+    EV_JOIN,     // nodul intra in swarm
+    EV_REQUEST,  // o cerere de chunk ajunge la sursa
+    EV_RESPONSE, // raspunsul (chunk sau "choked") ajunge inapoi
+    EV_WAKE,     // un nod fara cereri in curs reincearca
+    EV_TRACKER,  // un mesaj ajunge la tracker ("chunk" e tipul lui, "link" cati peeri vrea nodul)
+    EV_SWARM,    // raspunsul tracker-ului (link = 1) sau o notificare (link = 0) ajunge la nod
+    EV_PUSH,     // tracker-ul trimite notificarile adunate
+};
+
+// mesajele catre tracker
+enum sim_tracker_msg {
+    TRACKER_FULL_SWARM,
+    TRACKER_UPDATE,
+    TRACKER_FILE_DONE,
+};
+
+// legatura cu un vecin: cine e si ce index avem noi in lista lui
+struct sim_link {
+    int peer;
+    int back;
+};
+
+// ce atinge un vecin la fiecare chunk nou (starea si inceputul picker-ului) e pe prima linie de cache
+struct alignas(64) virtual_peer {
+    bool joined;
+    bool done;
+    bool wake_pending;
+    int inflight;
+    PiecePicker picker;
+    uint64_t join_ns;
+    uint64_t done_ns;
+    uint64_t upload_free_ns; // cand se elibereaza upload-ul
+    double ns_per_byte;
+    vector<sim_link> links;
+    int nr_owned;
+    vector<char> chunk_state;
+    SourceSelector selector;
+    UploadScheduler choker;
+    vector<int> received_from;
+    vector<uint64_t> choked_until;
+    vector<int> offered;  // peeri primiti de la tracker, inca neconectati
+    bool tracker_pending; // asteapta raspunsul la o cerere catre tracker
+    int tracker_want;     // cati peeri ii mai datoreaza tracker-ul ca abonat (starea tracker-ului)
+};
+
+// tracker-ul virtual
+struct sim_tracker {
+    vector<int> swarm;       // nodurile intrate, in ordinea intrarii
+    vector<int> subscribers; // cei care primesc notificari cu peerii noi
+    size_t pushed;           // primii "pushed" din swarm au fost deja anuntati abonatilor
+    bool push_armed;
+    uint64_t free_ns;        // cand termina mesajele de pana acum
+    uint64_t busy_ns;
+    uint64_t nr_msgs;
+    uint64_t nr_replies;
+    uint64_t nr_pushes;
+};
+
+struct sim_totals {
+    uint64_t nr_events;
+    uint64_t nr_requests;
+    uint64_t nr_choked;
+    uint64_t nr_chunks;
+};
+
+static vector<virtual_peer> peers;
+static sim_tracker tracker;
+static EventQueue events;
+static sim_totals totals;
+static int max_links;
+/* ce chunk-uri are fiecare nod, toate intr-un singur vector (un nod ocupa owned_stride cuvinte):
+la un chunk nou se verifica intai aici care vecini il au deja, fara sa le atingem structurile */
+static vector<uint64_t> owned_words;
+static vector<int> notified; // vecinii anuntati de un chunk nou (max_links)
+static int owned_stride;
+
+static uint64_t* owned_of(int p) {
+    return &owned_words[(size_t)p * owned_stride];
+}
+
+static bool owns(int p, int chunk) {
+    return (owned_of(p)[chunk >> 6] >> (chunk & 63)) & 1;
+}
+
+static uint64_t wall_now_ns() {
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+static uint64_t latency_ns() {
+    return (uint64_t)params.latency_us * 1000;
+}
+
+static void schedule(uint64_t time_ns, int type, int node, int link = NOT_FOUND, int chunk = NOT_FOUND,
+                     uint64_t sent_ns = 0) {
+    events.push({time_ns, type, node, link, chunk, sent_ns});
+}
+
+static void init_peer(int p, bool seed) {
+    virtual_peer& vp = peers[p];
+    vp.joined = false;
+    vp.done = seed;
+    vp.wake_pending = false;
+    vp.join_ns = 0;
+    vp.done_ns = 0;
+    vp.upload_free_ns = 0;
+    vp.ns_per_byte = 8000.0 / params.bandwidth_mbps;
+    if (rand() % 100 < params.slow_pct) {
+        vp.ns_per_byte *= 10;
+    }
+
+    vp.nr_owned = 0;
+    vp.chunk_state.assign(params.nr_chunks, seed ? CHUNK_OWNED : CHUNK_MISSING);
+    if (seed) {
+        for (int c = 0; c < params.nr_chunks; c++) {
+            owned_of(p)[c >> 6] |= (uint64_t)1 << (c & 63);
+        }
+        vp.nr_owned = params.nr_chunks;
+    }
+    vp.inflight = 0;
+    vp.tracker_pending = false;
+    vp.tracker_want = 0;
+
+    // seed-urile doar trimit, nu au nevoie de structurile de download
+    if (!seed) {
+        vp.picker.init(params.nr_chunks, max_links);
+        vp.selector.init(max_links, strcmp(params.selector, "legacy") != 0);
+        vp.choked_until.assign(max_links, 0);
+    }
+    vp.choker.init(max_links, params.upload_slots);
+    vp.received_from.assign(max_links, 0);
+}
+
+// vecinul "b" afla ce are "a" (bitmap-ul "have"), la conectare sau dupa un chunk nou
+static void announce(int a, const sim_link& link) {
+    virtual_peer& nb = peers[link.peer];
+    if (nb.done || peers[a].nr_owned == 0) {
+        return;
+    }
+    nb.picker.update_have(link.back, owned_of(a), owned_stride);
+}
+
+static bool connect(int a, int b) {
+    virtual_peer& pa = peers[a];
+    virtual_peer& pb = peers[b];
+    if (a == b || (int)pa.links.size() >= max_links || (int)pb.links.size() >= max_links) {
+        return false;
+    }
+    for (const sim_link& l : pa.links) {
+        if (l.peer == b) {
+            return false;
+        }
+    }
+
+    pa.links.push_back({b, (int)pb.links.size()});
+    pb.links.push_back({a, (int)pa.links.size() - 1});
+    announce(a, pa.links.back());
+    announce(b, pb.links.back());
+    return true;
+}
+
+// urmatorul chunk de cerut: rarest-first (PiecePicker) sau primul lipsa de la o pozitie aleatoare
+static int pick_chunk(virtual_peer& vp) {
+    if (strcmp(params.picker, "random") != 0) {
+        return vp.picker.next_chunk(vp.chunk_state);
+    }
+
+    int start = rand() % params.nr_chunks;
+    for (int i = 0; i < params.nr_chunks; i++) {
+        int c = (start + i) % params.nr_chunks;
+        if (vp.chunk_state[c] == CHUNK_MISSING && vp.picker.nr_seeds + vp.picker.holders(c) > 0) {
+            return c;
+        }
+    }
+    return NOT_FOUND;
+}
+
+// umplem fereastra de cereri; fara nimic de cerut, reincercam dupa un refuz sau un anunt nou
+static void fill_window(int p, uint64_t now_ns) {
+    virtual_peer& vp = peers[p];
+    if (vp.done) {
+        return;
+    }
+
+    while (vp.inflight < params.window) {
+        int c = pick_chunk(vp);
+        if (c == NOT_FOUND) {
+            break;
+        }
+
+        int src = vp.selector.pick([&](int i) {
+            return i < (int)vp.links.size() && vp.choked_until[i] <= now_ns && owns(vp.links[i].peer, c);
+        });
+        if (src == NOT_FOUND) {
+            break;
+        }
+
+        vp.chunk_state[c] = CHUNK_REQUESTED;
+        vp.inflight++;
+        vp.selector.on_request(src);
+        totals.nr_requests++;
+        schedule(now_ns + latency_ns(), EV_REQUEST, vp.links[src].peer, vp.links[src].back, c, now_ns);
+    }
+
+    if (vp.inflight > 0 || vp.wake_pending) {
+        return;
+    }
+
+    /* fara cereri in curs asteptam expirarea primului refuz, sau, daca avem prea putini vecini,
+    urmatoarea cerere la tracker; altfel ne trezeste anuntul unui chunk nou de la un vecin */
+    uint64_t wake_ns = 0;
+    for (int i = 0; i < (int)vp.links.size(); i++) {
+        if (vp.choked_until[i] > now_ns && (wake_ns == 0 || vp.choked_until[i] < wake_ns)) {
+            wake_ns = vp.choked_until[i];
+        }
+    }
+    if (wake_ns == 0 && (int)vp.links.size() < params.nr_neighbors / 2) {
+        // un abonat primeste oricum peerii noi, intreaba tracker-ul mai rar (ca PUSH_IDLE_MAX_MS)
+        int wait_ms = params.push ? PUSH_IDLE_MAX_MS : CHOKED_BACKOFF_MS;
+        wake_ns = now_ns + (uint64_t)wait_ms * 1000000;
+    }
+    if (wake_ns != 0) {
+        vp.wake_pending = true;
+        schedule(wake_ns, EV_WAKE, p);
+    }
+}
+
+static void send_to_tracker(int p, uint64_t now_ns, int type, int want = 0) {
+    schedule(now_ns + latency_ns(), EV_TRACKER, p, want, type);
+}
+
+// tracker-ul trateaza mesajele pe rand; intoarce cand pleaca raspunsul la cel de acum
+static uint64_t tracker_work(uint64_t now_ns) {
+    uint64_t cost_ns = (uint64_t)params.tracker_us * 1000;
+    tracker.free_ns = max(now_ns, tracker.free_ns) + cost_ns;
+    tracker.busy_ns += cost_ns;
+    return tracker.free_ns;
+}
+
+// tracker-ul alege pentru "p" cel mult "want" peeri aleatori din swarm[from..], fara el insusi
+static int offer_peers(int p, size_t from, int want) {
+    vector<int>& offered = peers[p].offered;
+    size_t n = tracker.swarm.size() - from;
+    int nr = 0;
+    for (size_t i = 0; i < n && nr < want; i++) {
+        int q = tracker.swarm[n <= (size_t)want ? from + i : from + rand() % n];
+        if (q != p) {
+            offered.push_back(q);
+            nr++;
+        }
+    }
+    return nr;
+}
+
+// schimbarile swarm-ului pleaca la abonati adunate, cel mult o data la PUSH_INTERVAL_MS
+static void arm_push(uint64_t now_ns) {
+    if (params.push && !tracker.push_armed && !tracker.subscribers.empty()) {
+        tracker.push_armed = true;
+        schedule(now_ns + (uint64_t)PUSH_INTERVAL_MS * 1000000, EV_PUSH, 0);
+    }
+}
+
+static void on_tracker(const sim_event& ev) {
+    int p = ev.node;
+    uint64_t reply_ns = tracker_work(ev.time_ns) + latency_ns();
+    tracker.nr_msgs++;
+
+    switch (ev.chunk) {
+        case TRACKER_FULL_SWARM: {
+            int nr = offer_peers(p, 0, ev.link);
+            tracker.swarm.push_back(p);
+            if (params.push && nr < ev.link) {
+                peers[p].tracker_want = ev.link - nr;
+                tracker.subscribers.push_back(p);
+            }
+            arm_push(ev.time_ns);
+            break;
+        }
+        case TRACKER_UPDATE:
+            offer_peers(p, 0, ev.link);
+            break;
+        default: {
+            // MSG_FILE_DONE: nodul ramane in swarm (ca seed), dar nu mai vrea notificari
+            vector<int>& subs = tracker.subscribers;
+            subs.erase(remove(subs.begin(), subs.end(), p), subs.end());
+            return;
+        }
+    }
+    tracker.nr_replies++;
+    schedule(reply_ns, EV_SWARM, p, 1);
+}
+
+// fiecare abonat primeste peerii intrati de la ultima notificare, cat ii mai trebuie
+static void on_push(uint64_t now_ns) {
+    tracker.push_armed = false;
+    size_t from = tracker.pushed;
+    tracker.pushed = tracker.swarm.size();
+
+    vector<int>& subs = tracker.subscribers;
+    for (size_t i = 0; i < subs.size(); i++) {
+        virtual_peer& vs = peers[subs[i]];
+        int nr = offer_peers(subs[i], from, vs.tracker_want);
+        if (nr == 0) {
+            continue;
+        }
+        vs.tracker_want -= nr;
+        tracker.nr_pushes++;
+        schedule(tracker_work(now_ns) + latency_ns(), EV_SWARM, subs[i], 0);
+        if (vs.tracker_want == 0) {
+            subs[i--] = subs.back();
+            subs.pop_back();
+        }
+    }
+}
+
+// nodul se conecteaza la peerii primiti de la tracker, pana are nr_neighbors vecini
+static void on_swarm(const sim_event& ev) {
+    virtual_peer& vp = peers[ev.node];
+    if (ev.link) {
+        vp.tracker_pending = false;
+    }
+    for (int q : vp.offered) {
+        if ((int)vp.links.size() >= params.nr_neighbors) {
+            break;
+        }
+        connect(ev.node, q);
+    }
+    vp.offered.clear();
+    fill_window(ev.node, ev.time_ns);
+}
+
+// la intrare nodul cere swarm-ul; pana la raspuns nu are vecini, deci nici ce cere
+static void join(int p, uint64_t now_ns) {
+    virtual_peer& vp = peers[p];
+    vp.joined = true;
+    vp.join_ns = now_ns;
+    vp.tracker_pending = true;
+    send_to_tracker(p, now_ns, TRACKER_FULL_SWARM, params.nr_neighbors);
+}
+
+// cine a intrat printre primii are putini vecini, ii mai cere tracker-ului (update)
+static void on_wake(int p, uint64_t now_ns) {
+    virtual_peer& vp = peers[p];
+    vp.wake_pending = false;
+    if ((int)vp.links.size() < params.nr_neighbors / 2 && !vp.tracker_pending) {
+        vp.tracker_pending = true;
+        send_to_tracker(p, now_ns, TRACKER_UPDATE, params.nr_neighbors - (int)vp.links.size());
+    }
+    fill_window(p, now_ns);
+}
+
+// cererea ajunge la sursa: raspunde "choked" imediat, sau trimite chunk-ul cand ii e liber upload-ul
+static void on_request(const sim_event& ev) {
+    virtual_peer& src = peers[ev.node];
+    const sim_link& to = src.links[ev.link];
+
+    if (src.choker.rechoke_due(ev.time_ns)) {
+        src.choker.rechoke(src.received_from, ev.time_ns);
+    }
+
+    uint64_t arrive_ns = ev.time_ns + latency_ns();
+    int chunk = ev.chunk;
+    if (!src.choker.allow(ev.link) || !owns(ev.node, ev.chunk)) {
+        chunk = -1 - ev.chunk; // raspuns negativ
+    } else {
+        uint64_t start_ns = max(ev.time_ns, src.upload_free_ns);
+        src.upload_free_ns = start_ns + (uint64_t)(params.chunk_size * src.ns_per_byte);
+        arrive_ns = src.upload_free_ns + latency_ns();
+    }
+    schedule(arrive_ns, EV_RESPONSE, to.peer, to.back, chunk, ev.sent_ns);
+}
+
+static void on_response(const sim_event& ev) {
+    int p = ev.node;
+    virtual_peer& vp = peers[p];
+    bool ok = ev.chunk >= 0;
+    int chunk = ok ? ev.chunk : -1 - ev.chunk;
+
+    vp.inflight--;
+    vp.selector.on_response(ev.link, ev.time_ns - ev.sent_ns, ok);
+
+    if (!ok) {
+        vp.choked_until[ev.link] = ev.time_ns + (uint64_t)CHOKED_BACKOFF_MS * 1000000;
+        vp.chunk_state[chunk] = CHUNK_MISSING;
+        totals.nr_choked++;
+    } else {
+        vp.chunk_state[chunk] = CHUNK_OWNED;
+        owned_of(p)[chunk >> 6] |= (uint64_t)1 << (chunk & 63);
+        vp.nr_owned++;
+        vp.received_from[ev.link]++;
+        totals.nr_chunks++;
+
+        /* vecinii afla imediat, iar cei care asteptau ceva de cerut se trezesc; cine are deja
+        chunk-ul (inclusiv cei terminati) nu il mai cere, deci nici disponibilitatea lui nu il
+        intereseaza. Cine are chunk-ul se vede din owned_words, asa ca picker-ul vecinului doar
+        numara detinatorul. Vecinii sunt imprastiati prin memorie, asa ca ii aducem pe toti in cache
+        inainte sa-i actualizam, ca ratarile sa se suprapuna */
+        int nr_notified = 0;
+        for (const sim_link& l : vp.links) {
+            if (!owns(l.peer, chunk)) {
+                notified[nr_notified++] = l.peer;
+                __builtin_prefetch(&peers[l.peer]);
+            }
+        }
+        for (int i = 0; i < nr_notified; i++) {
+            peers[notified[i]].picker.prefetch_holder(chunk);
+        }
+        for (int i = 0; i < nr_notified; i++) {
+            virtual_peer& nb = peers[notified[i]];
+            nb.picker.add_holder(chunk);
+            // fara cereri in curs chunk-ul nedetinut nu poate fi decat lipsa
+            if (nb.joined && nb.inflight == 0 && !nb.wake_pending) {
+                nb.wake_pending = true;
+                schedule(ev.time_ns, EV_WAKE, notified[i]);
+            }
+        }
+
+        if (vp.nr_owned == params.nr_chunks) {
+            vp.done = true;
+            vp.done_ns = ev.time_ns;
+            send_to_tracker(p, ev.time_ns, TRACKER_FILE_DONE);
+            return;
+        }
+    }
+
+    fill_window(p, ev.time_ns);
+}
+
+struct int_option {
+    const char* name;
+    int* value;
+    int min_value;
+};
+
+struct string_option {
+    const char* name;
+    const char** value;
+};
+
+static bool parse_params(int argc, char* argv[]) {
+    int_option int_options[] = {
+        {"--peers", &params.nr_peers, 2},
+        {"--seeds", &params.nr_seeds, 1},
+        {"--chunks", &params.nr_chunks, 1},
+        {"--chunk-size", &params.chunk_size, 1},
+        {"--neighbors", &params.nr_neighbors, 1},
+        {"--window", &params.window, 1},
+        {"--upload-slots", &params.upload_slots, 1},
+        {"--latency-us", &params.latency_us, 0},
+        {"--bandwidth", &params.bandwidth_mbps, 1},
+        {"--slow-pct", &params.slow_pct, 0},
+        {"--arrival-ms", &params.arrival_ms, 0},
+        {"--tracker-us", &params.tracker_us, 0},
+        {"--push", &params.push, 0},
+        {"--max-sim-s", &params.max_sim_s, 1},
+        {"--seed", &params.seed, 0},
+    };
+    string_option string_options[] = {
+        {"--selector", &params.selector},
+        {"--picker", &params.picker},
+    };
+
+    for (int i = 1; i < argc; i++) {
+        bool known = false;
+
+        for (int_option& o : int_options) {
+            if (strcmp(argv[i], o.name) == 0 && i + 1 < argc) {
+                *(o.value) = max(atoi(argv[++i]), o.min_value);
+                known = true;
+                break;
+            }
+        }
+        for (string_option& o : string_options) {
+            if (!known && strcmp(argv[i], o.name) == 0 && i + 1 < argc) {
+                *(o.value) = argv[++i];
+                known = true;
+                break;
+            }
+        }
+
+        if (!known) {
+            cerr << "Unknown option: " << argv[i] << endl;
+            return false;
+        }
+    }
+
+    params.nr_seeds = min(params.nr_seeds, params.nr_peers - 1);
+    return true;
+}
+
+/* fiecare chunk nou atinge starea a ~vecini noduri aleatoare, asa ca pentru swarm-uri mari timpul
+e dominat de ratarile de TLB. Toata memoria vine din heap-ul principal (fara mmap separat pentru
+alocarile mari), iar zona rezervata aici e marcata pentru huge pages si pastrata dupa free, ca
+alocarile de la initializare sa o refoloseasca */
+static void reserve_huge_heap(size_t bytes) {
+    mallopt(M_MMAP_MAX, 0);
+    mallopt(M_TRIM_THRESHOLD, -1);
+
+    char* area = (char*)malloc(bytes);
+    if (area == nullptr) {
+        return;
+    }
+    uintptr_t begin = ((uintptr_t)area + HUGE_PAGE_SIZE - 1) & ~(uintptr_t)(HUGE_PAGE_SIZE - 1);
+    uintptr_t end = ((uintptr_t)area + bytes) & ~(uintptr_t)(HUGE_PAGE_SIZE - 1);
+    if (end > begin) {
+        madvise((void*)begin, end - begin, MADV_HUGEPAGE);
+    }
+    free(area);
+}
+
+int main(int argc, char* argv[]) {
+    if (!parse_params(argc, argv)) {
+        return 1;
+    }
+    reserve_huge_heap((size_t)params.nr_peers * SIM_BYTES_PER_PEER);
+    srand(params.seed);
+    uint64_t wall_start_ns = wall_now_ns();
+
+    max_links = 2 * params.nr_neighbors;
+    notified.resize(max_links);
+
+    // primele noduri sunt seed-urile, intrate de la inceput
+    peers.resize(params.nr_peers);
+    owned_stride = bitmap::words_for(params.nr_chunks);
+    owned_words.assign((size_t)params.nr_peers * owned_stride, 0);
+    for (int p = 0; p < params.nr_peers; p++) {
+        bool seed = p < params.nr_seeds;
+        init_peer(p, seed);
+        uint64_t join_ns = seed ? 0 : 1 + (uint64_t)(rand() % (params.arrival_ms + 1)) * 1000000;
+        schedule(join_ns, EV_JOIN, p);
+    }
+
+    uint64_t max_sim_ns = (uint64_t)params.max_sim_s * 1000000000ull;
+    uint64_t now_ns = 0;
+    while (!events.empty()) {
+        sim_event ev = events.pop();
+        now_ns = ev.time_ns;
+        if (now_ns > max_sim_ns) {
+            break;
+        }
+        totals.nr_events++;
+
+        switch (ev.type) {
+            case EV_JOIN:
+                join(ev.node, now_ns);
+                break;
+            case EV_REQUEST:
+                on_request(ev);
+                break;
+            case EV_RESPONSE:
+                on_response(ev);
+                break;
+            case EV_WAKE:
+                on_wake(ev.node, now_ns);
+                break;
+            case EV_TRACKER:
+                on_tracker(ev);
+                break;
+            case EV_SWARM:
+                on_swarm(ev);
+                break;
+            case EV_PUSH:
+                on_push(now_ns);
+                break;
+        }
+
+        // dupa ce toti au terminat raman doar trezirile, nu mai e nimic de simulat
+        if (totals.nr_chunks == (uint64_t)(params.nr_peers - params.nr_seeds) * params.nr_chunks) {
+            break;
+        }
+    }
+    double wall_s = (wall_now_ns() - wall_start_ns) / 1e9;
+
+    // timpii de descarcare, de la intrarea fiecarui leecher
+    vector<double> download_s;
+    for (int p = params.nr_seeds; p < params.nr_peers; p++) {
+        if (peers[p].done) {
+            download_s.push_back((peers[p].done_ns - peers[p].join_ns) / 1e9);
+        }
+    }
+    sort(download_s.begin(), download_s.end());
+    double sum = 0;
+    for (double d : download_s) {
+        sum += d;
+    }
+    auto pct = [&](double q) {
+        return download_s.empty() ? 0 : download_s[(size_t)(q * (download_s.size() - 1))];
+    };
+
+    double sim_s = now_ns / 1e9;
+    printf("peers=%d seeds=%d chunks=%d selector=%s picker=%s\n", params.nr_peers, params.nr_seeds,
+           params.nr_chunks, params.selector, params.picker);
+    printf("done=%zu/%d sim_s=%.3f wall_s=%.3f speedup=%.1fx events=%llu events_per_s=%.0f\n",
+           download_s.size(), params.nr_peers - params.nr_seeds, sim_s, wall_s, sim_s / wall_s,
+           (unsigned long long)totals.nr_events, totals.nr_events / wall_s);
+    printf("download_s mean=%.3f p50=%.3f p99=%.3f max=%.3f requests=%llu choked=%.1f%%\n",
+           download_s.empty() ? 0 : sum / download_s.size(), pct(0.5), pct(0.99), pct(1.0),
+           (unsigned long long)totals.nr_requests, 100.0 * totals.nr_choked / max<uint64_t>(1, totals.nr_requests));
+    printf("tracker msgs=%llu replies=%llu pushes=%llu busy=%.1f%%\n", (unsigned long long)tracker.nr_msgs,
+           (unsigned long long)tracker.nr_replies, (unsigned long long)tracker.nr_pushes,
+           100.0 * tracker.busy_ns / max<uint64_t>(1, now_ns));
+    return 0;
+}
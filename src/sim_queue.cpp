@@ -0,0 +1,43 @@
+#include <algorithm>
+#include <vector>
+#include "sim_queue.h"
+
+using namespace std;
+
+EventQueue::EventQueue() : last_ns(0), nr_events(0) {}
+
+// evenimentele din trecut (fata de ultimul scos) nu sunt permise
+void EventQueue::push(const sim_event& ev) {
+    sim_event e = ev;
+    e.time_ns = max(e.time_ns, last_ns);
+    buckets[bucket_for(e.time_ns)].push_back(e);
+    nr_events++;
+}
+
+// scoate unul dintre evenimentele cu timpul minim (coada nu trebuie sa fie goala)
+sim_event EventQueue::pop() {
+    if (buckets[0].empty()) {
+        int b = 1;
+        while (buckets[b].empty()) {
+            b++;
+        }
+
+        // noul minim devine referinta, iar evenimentele bucket-ului coboara mai jos
+        uint64_t min_ns = buckets[b][0].time_ns;
+        for (const sim_event& e : buckets[b]) {
+            min_ns = min(min_ns, e.time_ns);
+        }
+        last_ns = min_ns;
+
+        vector<sim_event> moved;
+        moved.swap(buckets[b]);
+        for (const sim_event& e : moved) {
+            buckets[bucket_for(e.time_ns)].push_back(e);
+        }
+    }
+
+    sim_event ev = buckets[0].back();
+    buckets[0].pop_back();
+    nr_events--;
+    return ev;
+}
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <stdint.h>
+#include <vector>
+
+// un eveniment al simularii (vezi sim.cpp); "link" e indexul vecinului in lista nodului
+struct sim_event {
+    uint64_t time_ns;
+    int type;
+    int node;
+    int link;
+    int chunk;
+    uint64_t sent_ns;
+};
+
+/* coada de prioritati a simularii, ca radix heap: timpul evenimentelor scoase nu scade
+niciodata, asa ca fiecare eveniment sta in bucket-ul dat de cel mai semnificativ bit in
+care difera de ultimul timp scos. Un eveniment coboara cel mult de 64 de ori, deci push si
+pop costa O(1) amortizat, fara comparatii intre evenimente */
+class EventQueue {
+public:
+    EventQueue();
+
+    void push(const sim_event& ev);
+    sim_event pop();
+    bool empty() const {
+        return nr_events == 0;
+    }
+    size_t size() const {
+        return nr_events;
+    }
+
+private:
+    static const int NR_BUCKETS = 65;
+
+    uint64_t last_ns;
+    size_t nr_events;
+    std::vector<sim_event> buckets[NR_BUCKETS];
+
+    int bucket_for(uint64_t time_ns) const {
+        return time_ns == last_ns ? 0 : 64 - __builtin_clzll(time_ns ^ last_ns);
+    }
+};
@@ -0,0 +1,248 @@
+#include <mpi.h>
+#include <pthread.h>
+#include <time.h>
+#include <cstring>
+#include <cstdio>
+#include <iostream>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include "struct.h"
+#include "config.h"
+#include "stats.h"
+#include "digest.h"
+
+using namespace std;
+
+thread_local rank_stats thread_stats;
+
+// totalurile rank-ului, la care se aduna fiecare thread cand termina
+static rank_stats process_stats;
+static pthread_mutex_t process_stats_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static const char* op_names[NR_STAT_OPS] = {
+    "request_chunk",
+    "send_chunk",
+    "find_seed_for_chunk",
+    "verify_chunk",
+    "tracker_full_swarm",
+    "tracker_update_swarm",
+    "tracker_file_done",
+    "tracker_all_done",
+};
+
+static const char* counter_names[NR_STAT_COUNTERS] = {
+    "chunks_received",
+    "chunks_failed",
+    "chunks_local",
+    "chunks_resumed",
+    "chunks_served",
+    "chunks_by_digest",
+    "have_served",
+    "choked_sent",
+    "choked_received",
+    "endgame_duplicates",
+    "endgame_wasted",
+    "bytes_sent",
+    "bytes_received",
+    "payload_bytes",
+    "swarm_polls",
+    "pex_seeds",
+    "swarm_pushes",
+    "tracker_msgs",
+    "tracker_busy",
+    "init_us",
+    "download_us",
+};
+
+uint64_t stat_now_ns() {
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+void stat_record(stat_op op, uint64_t start_ns) {
+    uint64_t ns = stat_now_ns() - start_ns;
+    op_histogram& h = thread_stats.ops[op];
+
+    // indexul celui mai semnificativ bit da bucket-ul
+    int b = ns == 0 ? 0 : 63 - __builtin_clzll(ns);
+    if (b >= STAT_BUCKETS) {
+        b = STAT_BUCKETS - 1;
+    }
+
+    h.count++;
+    h.total_ns += ns;
+    h.buckets[b]++;
+}
+
+static void merge_stats(rank_stats& dst, const rank_stats& src) {
+    for (int c = 0; c < NR_STAT_COUNTERS; c++) {
+        dst.counters[c] += src.counters[c];
+    }
+    for (int op = 0; op < NR_STAT_OPS; op++) {
+        dst.ops[op].count += src.ops[op].count;
+        dst.ops[op].total_ns += src.ops[op].total_ns;
+        for (int b = 0; b < STAT_BUCKETS; b++) {
+            dst.ops[op].buckets[b] += src.ops[op].buckets[b];
+        }
+    }
+}
+
+void stats_flush_thread() {
+    pthread_mutex_lock(&process_stats_lock);
+    merge_stats(process_stats, thread_stats);
+    pthread_mutex_unlock(&process_stats_lock);
+
+    memset(&thread_stats, 0, sizeof(rank_stats));
+}
+
+// percentila "p" (0..1) in microsecunde, interpoland liniar in interiorul bucket-ului
+static double percentile_us(const op_histogram& h, double p) {
+    if (h.count == 0) {
+        return 0;
+    }
+
+    uint64_t target = (uint64_t)(p * h.count);
+    if (target < 1) {
+        target = 1;
+    }
+
+    uint64_t seen = 0;
+    for (int b = 0; b < STAT_BUCKETS; b++) {
+        if (seen + h.buckets[b] < target) {
+            seen += h.buckets[b];
+            continue;
+        }
+
+        double low = b == 0 ? 0 : (double)((uint64_t)1 << b);
+        double high = (double)((uint64_t)1 << (b + 1));
+        double frac = (double)(target - seen) / h.buckets[b];
+        return (low + (high - low) * frac) / 1000.0;
+    }
+
+    return 0;
+}
+
+static double mean_us(const op_histogram& h) {
+    return h.count == 0 ? 0 : (double)h.total_ns / h.count / 1000.0;
+}
+
+// cat din totalul chunk-urilor servite a servit fiecare rank
+static double upload_share(const vector<rank_stats>& all, int r, uint64_t total_served) {
+    return total_served == 0 ? 0 : (double)all[r].counters[CNT_CHUNKS_SERVED] / total_served;
+}
+
+// debitul payload-ului descarcat (octeti/us = MB/s)
+static double mb_per_s(uint64_t bytes, uint64_t us) {
+    return us == 0 ? 0 : (double)bytes / us;
+}
+
+// debitul intregului sistem: tot payload-ul, raportat la cea mai lunga descarcare
+static double total_mb_per_s(const vector<rank_stats>& all, const rank_stats& total) {
+    uint64_t longest_us = 0;
+    for (const rank_stats& r : all) {
+        longest_us = max(longest_us, r.counters[CNT_DOWNLOAD_US]);
+    }
+    return mb_per_s(total.counters[CNT_PAYLOAD_BYTES], longest_us);
+}
+
+static void write_json(FILE* out, const vector<rank_stats>& all, const rank_stats& total) {
+    int numtasks = all.size();
+
+    fprintf(out, "{\n  \"ranks\": %d,\n  \"trackers\": %d,\n", numtasks, config.nr_trackers);
+    fprintf(out, "  \"digest_kernel\": \"%s\",\n", digest_kernel_name());
+
+    fprintf(out, "  \"ops\": {\n");
+    for (int op = 0; op < NR_STAT_OPS; op++) {
+        const op_histogram& h = total.ops[op];
+        fprintf(out, "    \"%s\": {\"count\": %llu, \"mean_us\": %.3f, \"p50_us\": %.3f, \"p99_us\": %.3f}%s\n",
+                op_names[op], (unsigned long long)h.count, mean_us(h), percentile_us(h, 0.5),
+                percentile_us(h, 0.99), op + 1 < NR_STAT_OPS ? "," : "");
+    }
+    fprintf(out, "  },\n");
+
+    fprintf(out, "  \"totals\": {");
+    for (int c = 0; c < NR_STAT_COUNTERS; c++) {
+        fprintf(out, "%s\"%s\": %llu", c ? ", " : "", counter_names[c], (unsigned long long)total.counters[c]);
+    }
+    fprintf(out, "},\n");
+    fprintf(out, "  \"payload_mb_s\": %.3f,\n", total_mb_per_s(all, total));
+
+    fprintf(out, "  \"per_rank\": [\n");
+    for (int r = 0; r < numtasks; r++) {
+        fprintf(out, "    {\"rank\": %d, \"role\": \"%s\"", r, r < config.nr_trackers ? "tracker" : "peer");
+        for (int c = 0; c < NR_STAT_COUNTERS; c++) {
+            fprintf(out, ", \"%s\": %llu", counter_names[c], (unsigned long long)all[r].counters[c]);
+        }
+        fprintf(out, ", \"upload_share\": %.4f, \"download_mb_s\": %.3f}%s\n",
+                upload_share(all, r, total.counters[CNT_CHUNKS_SERVED]),
+                mb_per_s(all[r].counters[CNT_PAYLOAD_BYTES], all[r].counters[CNT_DOWNLOAD_US]),
+                r + 1 < numtasks ? "," : "");
+    }
+    fprintf(out, "  ]\n}\n");
+}
+
+// doua tabele separate de o linie goala: operatiile, apoi contoarele fiecarui rank
+static void write_csv(FILE* out, const vector<rank_stats>& all, const rank_stats& total) {
+    int numtasks = all.size();
+
+    fprintf(out, "op,count,mean_us,p50_us,p99_us\n");
+    for (int op = 0; op < NR_STAT_OPS; op++) {
+        const op_histogram& h = total.ops[op];
+        fprintf(out, "%s,%llu,%.3f,%.3f,%.3f\n", op_names[op], (unsigned long long)h.count, mean_us(h),
+                percentile_us(h, 0.5), percentile_us(h, 0.99));
+    }
+
+    fprintf(out, "\nrank,role");
+    for (int c = 0; c < NR_STAT_COUNTERS; c++) {
+        fprintf(out, ",%s", counter_names[c]);
+    }
+    fprintf(out, ",upload_share,download_mb_s\n");
+
+    for (int r = 0; r < numtasks; r++) {
+        fprintf(out, "%d,%s", r, r < config.nr_trackers ? "tracker" : "peer");
+        for (int c = 0; c < NR_STAT_COUNTERS; c++) {
+            fprintf(out, ",%llu", (unsigned long long)all[r].counters[c]);
+        }
+        fprintf(out, ",%.4f,%.3f\n", upload_share(all, r, total.counters[CNT_CHUNKS_SERVED]),
+                mb_per_s(all[r].counters[CNT_PAYLOAD_BYTES], all[r].counters[CNT_DOWNLOAD_US]));
+    }
+
+    fprintf(out, "\npayload_mb_s\n%.3f\n", total_mb_per_s(all, total));
+}
+
+void stats_report(int rank, int numtasks) {
+    // contoarele thread-ului principal (initializarea, tracker-ul)
+    stats_flush_thread();
+
+    vector<rank_stats> all(rank == TRACKER_RANK ? numtasks : 0);
+    MPI_Gather(&process_stats, sizeof(rank_stats), MPI_BYTE, all.data(), sizeof(rank_stats), MPI_BYTE,
+               TRACKER_RANK, MPI_COMM_WORLD);
+
+    if (rank != TRACKER_RANK || config.report_path == nullptr) {
+        return;
+    }
+
+    rank_stats total;
+    memset(&total, 0, sizeof(rank_stats));
+    for (int r = 0; r < numtasks; r++) {
+        merge_stats(total, all[r]);
+    }
+
+    FILE* out = fopen(config.report_path, "w");
+    if (out == nullptr) {
+        cerr << "[Tracker] Error opening report file: " << config.report_path << endl;
+        return;
+    }
+
+    // formatul se alege dupa extensie
+    string path = config.report_path;
+    if (path.size() >= 4 && path.compare(path.size() - 4, 4, ".csv") == 0) {
+        write_csv(out, all, total);
+    } else {
+        write_json(out, all, total);
+    }
+
+    fclose(out);
+}
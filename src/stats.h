@@ -0,0 +1,89 @@
+#pragma once
+
+#include <stdint.h>
+
+/* instrumentare mereu compilata: fiecare thread are contoarele si histogramele lui
+(thread_local, fara lock-uri pe drumul rapid), adunate per rank la sfarsitul thread-ului
+si apoi la tracker-ul principal, care scrie raportul (--report) */
+
+// operatii cronometrate (latenta in histograma logaritmica)
+enum stat_op {
+    OP_REQUEST_CHUNK,       // de la trimiterea cererii pana la sosirea raspunsului
+    OP_SEND_CHUNK,          // construirea si trimiterea raspunsului la o cerere
+    OP_FIND_SEED,           // alegerea sursei unui chunk
+    OP_VERIFY_CHUNK,        // SHA-256 peste payload-ul primit
+    OP_TRACKER_FULL_SWARM,  // cazurile din tracker_main_loop
+    OP_TRACKER_UPDATE_SWARM,
+    OP_TRACKER_FILE_DONE,
+    OP_TRACKER_ALL_DONE,
+    NR_STAT_OPS
+};
+
+// contoare simple
+enum stat_counter {
+    CNT_CHUNKS_RECEIVED,    // chunk-uri descarcate corect
+    CNT_CHUNKS_FAILED,      // cereri de chunk cu raspuns negativ sau gresit
+    CNT_CHUNKS_LOCAL,       // chunk-uri copiate din alt fisier propriu cu acelasi continut, fara transfer
+    CNT_CHUNKS_RESUMED,     // chunk-uri ramase de la o rulare intrerupta, reverificate, fara transfer
+    CNT_CHUNKS_SERVED,      // chunk-uri trimise altora
+    CNT_CHUNKS_BY_DIGEST,   // dintre ele, servite din alt fisier decat cel cerut (acelasi hash)
+    CNT_HAVE_SERVED,        // bitmap-uri "have" trimise altora
+    CNT_CHOKED_SENT,        // cereri refuzate pentru ca cel care cerea nu avea slot de upload
+    CNT_CHOKED_RECEIVED,    // cereri ale noastre refuzate asa
+    CNT_ENDGAME_DUPLICATES, // cereri in plus pentru chunk-uri deja cerute (endgame)
+    CNT_ENDGAME_WASTED,     // raspunsuri sosite dupa ce chunk-ul fusese deja obtinut
+    CNT_BYTES_SENT,
+    CNT_BYTES_RECEIVED,
+    CNT_PAYLOAD_BYTES,      // payload verificat primit (pentru MB/s)
+    CNT_SWARM_POLLS,        // update-uri de swarm cerute tracker-ului
+    CNT_PEX_SEEDS,          // seed-uri aflate de la alti peeri, inaintea tracker-ului
+    CNT_SWARM_PUSHES,       // notificari cu schimbari de swarm trimise de tracker
+    CNT_TRACKER_MSGS,       // mesaje procesate de tracker
+    CNT_TRACKER_BUSY,       // de cate ori mai astepta un mesaj dupa ce am procesat unul (nu cate)
+    CNT_INIT_US,            // durata initializarii (pana la primirea id-urilor)
+    CNT_DOWNLOAD_US,        // durata descarcarii tuturor fisierelor dorite
+    NR_STAT_COUNTERS
+};
+
+// bucket-ul b contine duratele din [2^b, 2^(b+1)) ns
+#define STAT_BUCKETS 48
+
+struct op_histogram {
+    uint64_t count;
+    uint64_t total_ns;
+    uint64_t buckets[STAT_BUCKETS];
+};
+
+// tot ce masoara un rank; trimis ca octeti la raport, deci fara pointeri
+struct rank_stats {
+    uint64_t counters[NR_STAT_COUNTERS];
+    op_histogram ops[NR_STAT_OPS];
+};
+
+extern thread_local rank_stats thread_stats;
+
+uint64_t stat_now_ns();
+
+inline void stat_add(stat_counter c, uint64_t value) {
+    thread_stats.counters[c] += value;
+}
+
+// inregistreaza o operatie inceputa la momentul "start_ns"
+void stat_record(stat_op op, uint64_t start_ns);
+
+// aduna contoarele thread-ului curent la cele ale rank-ului (la sfarsitul fiecarui thread)
+void stats_flush_thread();
+
+// colectiv pe MPI_COMM_WORLD: strange statisticile la tracker-ul principal si scrie raportul
+void stats_report(int rank, int numtasks);
+
+// cronometreaza blocul in care e declarat
+struct stat_timer {
+    stat_op op;
+    uint64_t start_ns;
+
+    stat_timer(stat_op op) : op(op), start_ns(stat_now_ns()) {}
+    ~stat_timer() {
+        stat_record(op, start_ns);
+    }
+};
@@ -0,0 +1,140 @@
+#include <mpi.h>
+#include <cstring>
+#include <vector>
+#include <array>
+#include "struct.h"
+
+using namespace std;
+
+// adauga "len" octeti la finalul buffer-ului
+static void append(vector<char>& buf, const void* data, size_t len) {
+    size_t offset = buf.size();
+    buf.resize(offset + len);
+    if (len > 0) {
+        memcpy(buf.data() + offset, data, len);
+    }
+}
+
+// [file_header][identifier x nr_total_chunks][sha256_digest x nr_payload_digests]
+void pack_file_data(const file_data& file, vector<char>& buf) {
+    file_header header;
+    memset(&header, 0, sizeof(file_header));
+    memcpy(header.filename, file.filename, MAX_FILENAME);
+    header.nr_total_chunks = file.nr_total_chunks;
+    header.nr_payload_digests = file.payload_digests.size();
+
+    append(buf, &header, sizeof(file_header));
+    append(buf, file.identifiers.data(), file.nr_total_chunks * sizeof(identifier));
+    append(buf, file.payload_digests.data(), file.payload_digests.size() * sizeof(sha256_digest));
+}
+
+// intoarce cati octeti au fost consumati din buffer
+int unpack_file_data(const char* buf, file_data& file) {
+    file_header header;
+    memcpy(&header, buf, sizeof(file_header));
+
+    memcpy(file.filename, header.filename, MAX_FILENAME);
+    file.nr_total_chunks = header.nr_total_chunks;
+    file.identifiers.resize(header.nr_total_chunks);
+    int offset = sizeof(file_header);
+    memcpy(file.identifiers.data(), buf + offset, header.nr_total_chunks * sizeof(identifier));
+    offset += header.nr_total_chunks * sizeof(identifier);
+
+    file.payload_digests.resize(header.nr_payload_digests);
+    memcpy(file.payload_digests.data(), buf + offset, header.nr_payload_digests * sizeof(sha256_digest));
+    offset += header.nr_payload_digests * sizeof(sha256_digest);
+
+    return offset;
+}
+
+// [int version][int nr_bits][cuvinte is_seed][cuvinte is_peer]
+void pack_swarm_update(const swarm_update& owners, vector<char>& buf) {
+    int nr_bits = owners.is_seed.nr_bits;
+
+    append(buf, &owners.version, sizeof(int));
+    append(buf, &nr_bits, sizeof(int));
+    append(buf, owners.is_seed.words.data(), owners.is_seed.words.size() * sizeof(uint64_t));
+    append(buf, owners.is_peer.words.data(), owners.is_peer.words.size() * sizeof(uint64_t));
+}
+
+int unpack_swarm_update(const char* buf, swarm_update& owners) {
+    int nr_bits;
+    memcpy(&owners.version, buf, sizeof(int));
+    memcpy(&nr_bits, buf + sizeof(int), sizeof(int));
+
+    owners.is_seed.resize(nr_bits);
+    owners.is_peer.resize(nr_bits);
+
+    int words_len = bitmap::words_for(nr_bits) * sizeof(uint64_t);
+    const char* words = buf + 2 * sizeof(int);
+    memcpy(owners.is_seed.words.data(), words, words_len);
+    memcpy(owners.is_peer.words.data(), words + words_len, words_len);
+
+    return 2 * sizeof(int) + 2 * words_len;
+}
+
+// [swarm_update][file_data]
+void pack_swarm_data(const swarm_data& swarm, vector<char>& buf) {
+    pack_swarm_update(swarm.owners, buf);
+    pack_file_data(swarm.file_metadata, buf);
+}
+
+int unpack_swarm_data(const char* buf, swarm_data& swarm) {
+    int offset = unpack_swarm_update(buf, swarm.owners);
+    return offset + unpack_file_data(buf + offset, swarm.file_metadata);
+}
+
+// aplica raspunsul tracker-ului peste swarm-ul pe care il avem deja
+void apply_swarm_update_reply(const char* buf, swarm_update& owners) {
+    swarm_update_header header;
+    memcpy(&header, buf, sizeof(swarm_update_header));
+    buf += sizeof(swarm_update_header);
+
+    if (header.type == UPDATE_FULL) {
+        unpack_swarm_update(buf, owners);
+        return;
+    }
+
+    // schimbarile vin in ordinea versiunilor, deci ultima pentru un rank castiga
+    for (int i = 0; i < header.count; i++) {
+        swarm_change change;
+        memcpy(&change, buf + i * sizeof(swarm_change), sizeof(swarm_change));
+        owners.is_seed.assign(change.rank, change.state & OWNER_SEED);
+        owners.is_peer.assign(change.rank, change.state & OWNER_PEER);
+    }
+    owners.version = header.version;
+}
+
+bool hex_to_identifier(const char* hex, identifier& id) {
+    // valoarea fiecarei cifre hex, -1 pentru restul caracterelor
+    static const array<int8_t, 256> digit_value = [] {
+        array<int8_t, 256> t;
+        t.fill(-1);
+        for (int i = 0; i < 10; i++) {
+            t['0' + i] = i;
+        }
+        for (int i = 0; i < 6; i++) {
+            t['a' + i] = t['A' + i] = 10 + i;
+        }
+        return t;
+    }();
+
+    for (int i = 0; i < DIGEST_SIZE; i++) {
+        int hi = digit_value[(uint8_t)hex[2 * i]];
+        int lo = digit_value[(uint8_t)hex[2 * i + 1]];
+        if ((hi | lo) < 0) {
+            return false;
+        }
+        id.digest[i] = hi << 4 | lo;
+    }
+    return true;
+}
+
+void identifier_to_hex(const identifier& id, char* hex) {
+    static const char digits[] = "0123456789abcdef";
+
+    for (int i = 0; i < DIGEST_SIZE; i++) {
+        hex[2 * i] = digits[id.digest[i] >> 4];
+        hex[2 * i + 1] = digits[id.digest[i] & 15];
+    }
+}
@@ -1,55 +1,174 @@
 #pragma once
 
+#include <mpi.h>
+#include <vector>
+#include "bitmap.h"
+#include "sha256.h"
+
+// tracker-ul principal (coordonator); cu --trackers N, rank-urile 0 .. N-1 sunt toate tracker-e
 #define TRACKER_RANK 0
-#define MAX_FILES 10
+#define NR_TRACKERS 1
 #define MAX_FILENAME 15
 #define MAX_OUTPUT_FILENAME 33
-#define HASH_SIZE 32
-#define MAX_CHUNKS 100
-
-// 10 clienti maxim, dar numeratom 1 .. 10 fara 0
-#define MAX_CLIENTS 11
+// fisierul de progres al unei descarcari sta langa output, cu acelasi nume plus sufixul
+#define PROGRESS_SUFFIX ".progress"
+#define MAX_PROGRESS_FILENAME (MAX_OUTPUT_FILENAME + 9)
+#define HASH_SIZE 32   // caractere hex ale unui hash in fisierele de input/output
+#define DIGEST_SIZE 16 // octetii pe care ii reprezinta, forma in care e tinut in memorie si pe fir
 
-// tag-uri initializare metadate
-#define MSG_INIT_NR_FILES     59000
-#define MSG_INIT_FILES        59001
+/* initializarea (metadate, id-uri, swarm-urile shard-urilor) se face prin operatii
+colective, deci nu are tag-uri proprii */
 
 // tag-uri comunicatie tracker-peer
-#define MSG_CLIENT_READY_DOWNLOAD     69000
-#define MSG_CLIENT_READY_UPLOAD       69001
 #define MSG_REQ_FULL_SWARM    69002
 #define MSG_REQ_UPDATE_SWARM  69003
 #define MSG_SWARM_DATA        69004
 #define MSG_UPDATE_SWARM      69005
 
 #define MSG_CHUNK_REQUEST     69006
-#define MSG_CHUNK_RESPONSE    69007
 #define MSG_FILE_DONE         69008
 #define MSG_ALL_DONE          69009
 #define MSG_TRACKER_STOP      69010
+// schimbarile unui swarm, trimise de tracker abonatilor fara sa fie cerute ([file_id][raspuns update])
+#define MSG_SWARM_PUSH        69011
+
+// raspunsul la o cerere de chunk are tag-ul MSG_CHUNK_RESPONSE + token-ul cererii
+#define MSG_CHUNK_RESPONSE    70000
 
 #define NOT_FOUND -1
-#define FIND_NUM_TRIES 2
+#define FIND_NUM_TRIES 2 // euristica veche de alegere a sursei (--selector legacy)
+// alegerea adaptiva a sursei: ponderea unei masuratori noi si rata de succes minima luata in calcul
+#define SELECTOR_EWMA_ALPHA 0.2
+#define SELECTOR_MIN_OK_RATE 0.05
 #define BIG_VALUE 1 << 30
-#define PEER_DECISSION_TRESHOLD 1
+
+// tipul unei cereri catre thread-ul de upload al altui peer
+#define REQUEST_CHUNK 0
+#define REQUEST_HAVE  1
+
+// de la cati peeri (prin rotatie) cerem bitmap-ul "have" la fiecare update de swarm
+#define HAVE_REQUESTS_PER_UPDATE 4
+
+// cate schimbari de membri retine tracker-ul per swarm pentru update-uri incrementale
+#define SWARM_HISTORY_SIZE 256
+
+// tipul raspunsului la MSG_REQ_UPDATE_SWARM
+#define UPDATE_UNCHANGED 0
+#define UPDATE_DELTA     1
+#define UPDATE_FULL      2
+
+// starea unui client intr-un swarm (flag-uri)
+#define OWNER_SEED 1
+#define OWNER_PEER 2
+
+// cate cereri de chunk tine un peer in curs simultan (implicit)
+#define DOWNLOAD_WINDOW 8
+// cate fisiere descarca un peer in paralel (implicit)
+#define PARALLEL_DOWNLOADS 4
+// cate receive-uri persistente are thread-ul de upload pre-postate (implicit)
+#define UPLOAD_RECV_SLOTS 16
+// cati peeri deserveste simultan thread-ul de upload (implicit), restul primesc "choked"
+#define UPLOAD_SLOTS 4
+// la cat timp se reevalueaza cine e deblocat si cat ocoleste un peer sursa care l-a refuzat
+#define RECHOKE_INTERVAL_MS 20
+#define CHOKED_BACKOFF_MS RECHOKE_INTERVAL_MS
+// la cate reevaluari se schimba peer-ul deblocat optimist
+#define OPTIMISTIC_UNCHOKE_EVERY 3
+// cati octeti de payload are un chunk (implicit 0: se transfera doar hash-ul)
+#define CHUNK_PAYLOAD_SIZE 0
+// sub cate chunk-uri ramase dintr-un fisier intra descarcarea lui in endgame (implicit), 0 = niciodata
+#define ENDGAME_THRESHOLD 8
+// cate cereri simultane (inclusiv cea initiala) poate avea un chunk in endgame
+#define ENDGAME_MAX_REQUESTS 3
+// la reluarea unei descarcari, cate chunk-uri reverifica cel putin fiecare thread
+#define RESUME_CHUNKS_PER_THREAD 256
+
+// cate seed-uri ale fisierului anunta un peer in fiecare raspuns la o cerere de chunk (PEX)
+#define PEX_MAX_RANKS 4
+// dupa cate raspunsuri cerem update la swarm de la tracker: se dubleaza cat timp nu se schimba nimic
+#define SWARM_POLL_MIN 10
+#define SWARM_POLL_MAX 160
+// notificarile unui swarm pleaca la cel mult o data la PUSH_INTERVAL_MS, adunand schimbarile dintre ele
+#define PUSH_INTERVAL_MS 2
+// cate notificari (Isend) poate avea tracker-ul in curs simultan
+#define PUSH_MAX_INFLIGHT 256
+/* fara nimic de cerut, un peer cu notificari asteapta una cel mult PUSH_IDLE_MIN_MS (dublat la
+fiecare asteptare fara rezultat, pana la PUSH_IDLE_MAX_MS) si abia apoi intreaba tracker-ul */
+#define PUSH_IDLE_MIN_MS 2
+#define PUSH_IDLE_MAX_MS 64
+
+// starea unui chunk din perspectiva peer-ului
+#define CHUNK_MISSING   0
+#define CHUNK_REQUESTED 1
+#define CHUNK_OWNED     2
+
+// starea descarcarii unui fisier dorit
+#define DOWNLOAD_PENDING 0
+#define DOWNLOAD_ACTIVE  1
+#define DOWNLOAD_DONE    2
 
 // structuri date comune folosite in comunicatie
 struct identifier {
-    char hash[HASH_SIZE];
+    uint8_t digest[DIGEST_SIZE];
+};
+
+// antetul unui fisier pe fir, urmat de nr_total_chunks identificatori
+struct file_header {
+    char filename[MAX_FILENAME];
+    int nr_total_chunks;
+    int nr_payload_digests; // 0 daca nu rulam cu payload
 };
 
 struct file_data {
     char filename[MAX_FILENAME];
-    identifier identifiers[MAX_CHUNKS];
     int nr_total_chunks;
+    std::vector<identifier> identifiers;
+    std::vector<sha256_digest> payload_digests; // SHA-256 al continutului fiecarui chunk (--chunk-size)
 };
 
+// bitmap-uri indexate dupa rank, versiunea creste la fiecare schimbare de membri
 struct swarm_update {
-    bool is_seed[MAX_CLIENTS];
-    bool is_peer[MAX_CLIENTS];
+    int version;
+    bitmap is_seed;
+    bitmap is_peer;
+};
+
+// peer-ul cere doar schimbarile de dupa versiunea pe care o are deja
+struct swarm_update_request {
+    int file_id;
+    int version;
+};
+
+// o schimbare din swarm: noua stare (OWNER_SEED | OWNER_PEER) a unui rank
+struct swarm_change {
+    int version;
+    int rank;
+    int state;
+};
+
+/* raspunsul la MSG_REQ_UPDATE_SWARM: antetul e urmat de "count" swarm_change-uri
+(UPDATE_DELTA), de un swarm_update serializat (UPDATE_FULL) sau de nimic (UPDATE_UNCHANGED) */
+struct swarm_update_header {
+    int type;
+    int version;
+    int count;
 };
 
 struct swarm_data {
     swarm_update owners;
     file_data file_metadata;
 };
+
+/* structurile de mai sus au dimensiune variabila, asa ca pe fir se trimite doar
+partea folosita, serializata intr-un buffer de char-uri (vezi struct.cpp) */
+void pack_file_data(const file_data& file, std::vector<char>& buf);
+int unpack_file_data(const char* buf, file_data& file);
+void pack_swarm_update(const swarm_update& owners, std::vector<char>& buf);
+int unpack_swarm_update(const char* buf, swarm_update& owners);
+void pack_swarm_data(const swarm_data& swarm, std::vector<char>& buf);
+int unpack_swarm_data(const char* buf, swarm_data& swarm);
+void apply_swarm_update_reply(const char* buf, swarm_update& owners);
+
+// conversii intre hash-ul hex (HASH_SIZE caractere) si digest; false daca nu e hex valid
+bool hex_to_identifier(const char* hex, identifier& id);
+void identifier_to_hex(const identifier& id, char* hex);
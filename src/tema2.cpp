@@ -4,30 +4,45 @@
 #include <vector>
 
 #include "struct.h"
+#include "config.h"
 #include "tracker.h"
 #include "peer.h"
+#include "stats.h"
 
 using namespace std;
 
 int main(int argc, char* argv[]) {
     int numtasks, rank;
 
+    // nivelul de thread-uri cerut depinde de --comm-thread, deci optiunile se citesc inainte
+    parse_config(argc, argv);
+
     int provided;
-    MPI_Init_thread(&argc, &argv, MPI_THREAD_MULTIPLE, &provided);
-    if (provided < MPI_THREAD_MULTIPLE) {
-        cerr << "MPI does not support multi-threading" << endl;
+    int required = config.comm_thread ? MPI_THREAD_FUNNELED : MPI_THREAD_MULTIPLE;
+    MPI_Init_thread(&argc, &argv, required, &provided);
+    if (provided < required) {
+        cerr << "MPI does not support the required thread level"
+             << (config.comm_thread ? "" : ", try --comm-thread 1") << endl;
         exit(-1);
     }
 
     MPI_Comm_size(MPI_COMM_WORLD, &numtasks);
     MPI_Comm_rank(MPI_COMM_WORLD, &rank);
 
-    if (rank == TRACKER_RANK) {
+    if (config.nr_trackers >= numtasks) {
+        cerr << "Need at least one client besides the " << config.nr_trackers << " trackers" << endl;
+        exit(-1);
+    }
+
+    if (rank < config.nr_trackers) {
         tracker(numtasks, rank);
     } else {
         peer(numtasks, rank);
     }
 
+    // toate rank-urile participa, raportul il scrie doar tracker-ul principal
+    stats_report(rank, numtasks);
+
     MPI_Finalize();
     return 0;
 }
@@ -2,83 +2,354 @@
 #include <pthread.h>
 #include <iostream>
 #include <unistd.h>
+#include <cstring>
+#include <vector>
+#include <algorithm>
 #include "struct.h"
+#include "config.h"
 #include "tracker.h"
+#include "stats.h"
 
 using namespace std;
 
 // constructor si initializare
-TrackerManager::TrackerManager(int numtasks) : numtasks(numtasks) {
-    swarm_data* sw;
+TrackerManager::TrackerManager(int numtasks, int rank) : numtasks(numtasks), shard(rank) {
+    nr_shards = config.nr_trackers;
     nr_files = 0;
-    nr_initial_files = 0;
-
-    for (int i = 0; i < MAX_FILES; i++) {
-        sw = &(swarms[i]);
-    
-        // initial presupunem ca nimeni nu are nimic
-        for (int j = 0; j < MAX_CLIENTS; j++) {
-            sw->owners.is_seed[j] = false;
-            sw->owners.is_peer[j] = false;
+    nr_push_inflight = 0;
+
+    // pereche cu apelurile colective din constructorul PeerManager
+    transport = create_transport(config.transport, config.chunk_size);
+    MPI_Comm_split(MPI_COMM_WORLD, 0, rank, &tracker_comm);
+}
+
+TrackerManager::~TrackerManager() {
+    delete transport;
+    MPI_Comm_free(&tracker_comm);
+}
+
+int TrackerManager::find_file_index(const char* filename) {
+    auto it = file_ids.find(filename);
+    if (it == file_ids.end()) {
+        return NOT_FOUND;
+    }
+    return it->second;
+}
+
+// indexul swarm-ului in acest shard, sau NOT_FOUND daca fisierul nu e al lui
+int TrackerManager::local_index(int file_id) {
+    if (file_id < 0 || file_id % nr_shards != shard || file_id / nr_shards >= nr_files) {
+        return NOT_FOUND;
+    }
+    return file_id / nr_shards;
+}
+
+// adauga un swarm nou pentru fisier, in care initial nimeni nu are nimic
+int TrackerManager::add_swarm(const file_data& file) {
+    swarms.emplace_back();
+    swarm_data& sw = swarms.back();
+
+    sw.file_metadata = file;
+    sw.owners.version = 0;
+    sw.owners.is_seed.resize(numtasks);
+    sw.owners.is_peer.resize(numtasks);
+
+    history.emplace_back();
+    history.back().base_version = 0;
+
+    file_ids[file.filename] = nr_files;
+    return nr_files++;
+}
+
+int TrackerManager::owner_state(int idx, int rank) {
+    swarm_update& owners = swarms[idx].owners;
+    return (owners.is_seed.test(rank) ? OWNER_SEED : 0) | (owners.is_peer.test(rank) ? OWNER_PEER : 0);
+}
+
+// schimba starea unui rank in swarm si o noteaza in istoric (noua versiune)
+void TrackerManager::set_owner_state(int idx, int rank, int state) {
+    if (owner_state(idx, rank) == state) {
+        return;
+    }
+
+    swarm_update& owners = swarms[idx].owners;
+    owners.is_seed.assign(rank, state & OWNER_SEED);
+    owners.is_peer.assign(rank, state & OWNER_PEER);
+    owners.version++;
+
+    swarm_history& hist = history[idx];
+    hist.changes.push_back({owners.version, rank, state});
+
+    // pastram doar schimbarile recente, cine e mai in urma primeste swarm-ul complet
+    if ((int)hist.changes.size() > SWARM_HISTORY_SIZE) {
+        int nr_dropped = hist.changes.size() - SWARM_HISTORY_SIZE / 2;
+        hist.base_version = hist.changes[nr_dropped - 1].version;
+        hist.changes.erase(hist.changes.begin(), hist.changes.begin() + nr_dropped);
+    }
+}
+
+// trimite swarm-ul complet (hash-uri, nr_chunks, cine are ce), sau unul gol daca idx == NOT_FOUND
+void TrackerManager::send_swarm_data(int idx, int dest) {
+    vector<char> buf;
+
+    if (idx == NOT_FOUND) {
+        swarm_data empty;
+        memset(empty.file_metadata.filename, 0, MAX_FILENAME);
+        empty.file_metadata.nr_total_chunks = 0;
+        empty.owners.version = 0;
+        empty.owners.is_seed.resize(numtasks);
+        empty.owners.is_peer.resize(numtasks);
+        pack_swarm_data(empty, buf);
+    } else {
+        pack_swarm_data(swarms[idx], buf);
+    }
+
+    MPI_Send(buf.data(), buf.size(), MPI_BYTE, dest, MSG_SWARM_DATA, MPI_COMM_WORLD);
+    stat_add(CNT_BYTES_SENT, buf.size());
+}
+
+/* adauga la "buf" ce s-a schimbat in swarm de la versiunea "since_version": nimic daca
+e la zi, lista de schimbari daca o mai avem in istoric, altfel bitmap-urile complete */
+void TrackerManager::build_swarm_update(int idx, int since_version, vector<char>& buf) {
+    int start = buf.size();
+    swarm_update_header header;
+    header.count = 0;
+    buf.resize(start + sizeof(swarm_update_header));
+
+    if (idx == NOT_FOUND) {
+        swarm_update empty;
+        empty.version = 0;
+        empty.is_seed.resize(numtasks);
+        empty.is_peer.resize(numtasks);
+
+        header.type = UPDATE_FULL;
+        header.version = 0;
+        pack_swarm_update(empty, buf);
+    } else {
+        swarm_update& owners = swarms[idx].owners;
+        swarm_history& hist = history[idx];
+        header.version = owners.version;
+
+        // schimbarile de dupa since_version sunt la finalul istoricului
+        int first = hist.changes.size();
+        while (first > 0 && hist.changes[first - 1].version > since_version) {
+            first--;
+        }
+        int nr_changes = hist.changes.size() - first;
+        int full_size = 2 * sizeof(int) + 2 * owners.is_seed.words.size() * sizeof(uint64_t);
+
+        if (since_version == owners.version) {
+            header.type = UPDATE_UNCHANGED;
+        } else if (since_version >= hist.base_version && since_version < owners.version
+                   && nr_changes * (int)sizeof(swarm_change) < full_size) {
+            header.type = UPDATE_DELTA;
+            header.count = nr_changes;
+            buf.resize(start + sizeof(swarm_update_header) + nr_changes * sizeof(swarm_change));
+            memcpy(buf.data() + start + sizeof(swarm_update_header), hist.changes.data() + first,
+                   nr_changes * sizeof(swarm_change));
+        } else {
+            header.type = UPDATE_FULL;
+            pack_swarm_update(owners, buf);
         }
-        sw->file_metadata.nr_total_chunks = 0;
-        memset(sw->file_metadata.filename, 0, MAX_FILENAME);
     }
+
+    memcpy(buf.data() + start, &header, sizeof(swarm_update_header));
 }
 
-int TrackerManager::find_file_index(const char* filename) {
+// raspunsul la MSG_REQ_UPDATE_SWARM
+void TrackerManager::send_swarm_update(int idx, int dest, int since_version) {
+    vector<char> buf;
+    build_swarm_update(idx, since_version, buf);
+
+    MPI_Send(buf.data(), buf.size(), MPI_BYTE, dest, MSG_UPDATE_SWARM, MPI_COMM_WORLD);
+    stat_add(CNT_BYTES_SENT, buf.size());
+}
+
+// dupa impartirea swarm-urilor nimeni nu e abonat si nu e nimic de trimis
+void TrackerManager::init_push_state() {
+    subscribers.assign(nr_files, vector<int>());
+    pushed_version.resize(nr_files);
     for (int i = 0; i < nr_files; i++) {
-        if (strcmp(swarms[i].file_metadata.filename, filename) == 0) {
-            return i;
+        pushed_version[i] = swarms[i].owners.version;
+    }
+    last_push_ns.assign(nr_files, 0);
+    is_dirty.assign(nr_files, false);
+}
+
+/* cine cere swarm-ul complet il descarca, deci primeste de acum schimbarile; swarm-ul primit
+e la versiunea curenta, iar notificarile pleaca de la pushed_version <= ea, deci ii raman valide */
+void TrackerManager::subscribe(int idx, int rank) {
+    vector<int>& subs = subscribers[idx];
+    if (config.swarm_push && find(subs.begin(), subs.end(), rank) == subs.end()) {
+        subs.push_back(rank);
+    }
+}
+
+void TrackerManager::unsubscribe(int idx, int rank) {
+    vector<int>& subs = subscribers[idx];
+    subs.erase(remove(subs.begin(), subs.end(), rank), subs.end());
+}
+
+void TrackerManager::mark_dirty(int idx) {
+    if (!is_dirty[idx] && swarms[idx].owners.version != pushed_version[idx]) {
+        is_dirty[idx] = true;
+        dirty.push_back(idx);
+    }
+}
+
+bool TrackerManager::push_pending() {
+    return !dirty.empty();
+}
+
+/* trimitem (Isend) schimbarile adunate ale fiecarui swarm, cel mult o data la PUSH_INTERVAL_MS
+per swarm, iar un swarm ai carui abonati nu incap in PUSH_MAX_INFLIGHT asteapta sa se elibereze loc */
+void TrackerManager::flush_pushes() {
+    for (int i = 0; i < (int)batches.size(); i++) {
+        int done;
+        MPI_Testall(batches[i].reqs.size(), batches[i].reqs.data(), &done, MPI_STATUSES_IGNORE);
+        if (done) {
+            nr_push_inflight -= batches[i].reqs.size();
+            batches.erase(batches.begin() + i--);
+        }
+    }
+
+    uint64_t now_ns = stat_now_ns();
+    for (int i = 0; i < (int)dirty.size(); i++) {
+        int idx = dirty[i];
+        vector<int>& subs = subscribers[idx];
+
+        if (now_ns - last_push_ns[idx] < (uint64_t)PUSH_INTERVAL_MS * 1000000) {
+            continue;
+        }
+        if (nr_push_inflight > 0 && nr_push_inflight + (int)subs.size() > PUSH_MAX_INFLIGHT) {
+            continue;
+        }
+
+        if (!subs.empty()) {
+            batches.emplace_back();
+            push_batch& batch = batches.back();
+            int file_id = idx * nr_shards + shard;
+            batch.buf.resize(sizeof(int));
+            memcpy(batch.buf.data(), &file_id, sizeof(int));
+            build_swarm_update(idx, pushed_version[idx], batch.buf);
+
+            batch.reqs.resize(subs.size());
+            for (int s = 0; s < (int)subs.size(); s++) {
+                MPI_Isend(batch.buf.data(), batch.buf.size(), MPI_BYTE, subs[s], MSG_SWARM_PUSH,
+                          MPI_COMM_WORLD, &batch.reqs[s]);
+            }
+            nr_push_inflight += subs.size();
+            stat_add(CNT_SWARM_PUSHES, subs.size());
+            stat_add(CNT_BYTES_SENT, subs.size() * batch.buf.size());
         }
+
+        pushed_version[idx] = swarms[idx].owners.version;
+        last_push_ns[idx] = now_ns;
+        is_dirty[idx] = false;
+        dirty.erase(dirty.begin() + i--);
     }
-    return NOT_FOUND;
 }
 
-void TrackerManager::receive_nr_files_to_process() {
-    nr_initial_files = 0;
-    for (int rank = 1; rank < numtasks; rank++) {
-        int num;
-        MPI_Recv(&num, 1, MPI_INT, rank, MSG_INIT_NR_FILES, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
-        nr_initial_files += num;
+// fiecare peer isi goleste notificarile inainte sa se opreasca (vezi MSG_ALL_DONE)
+void TrackerManager::finish_pushes() {
+    for (push_batch& batch : batches) {
+        MPI_Waitall(batch.reqs.size(), batch.reqs.data(), MPI_STATUSES_IGNORE);
     }
+    batches.clear();
+    nr_push_inflight = 0;
 }
 
-// primeste datele initiale despre fisiere
-void TrackerManager::receive_all_initial_files_data() {
-    int found_index, cur_index = 0;
-    file_data* cur_file;
-    swarm_data* sw;
-    int sender_rank;
+/* pasul 1: metadatele fisierelor detinute de clienti ajung la tracker-ul principal,
+intai dimensiunile (MPI_Gather), apoi datele (MPI_Gatherv); tracker-ele contribuie cu 0 octeti */
+void TrackerManager::receive_initial_files() {
+    int empty_len = 0;
+    vector<int> lens(numtasks), displs(numtasks);
+    vector<char> buf;
 
-    nr_files = 0;
-    for (int i = 0; i < nr_initial_files; i++) {
-        cur_file = &(swarms[cur_index].file_metadata);
+    MPI_Gather(&empty_len, 1, MPI_INT, lens.data(), 1, MPI_INT, TRACKER_RANK, MPI_COMM_WORLD);
 
-        MPI_Status status;
-        MPI_Recv(cur_file, sizeof(file_data), MPI_BYTE, MPI_ANY_SOURCE, MSG_INIT_FILES, MPI_COMM_WORLD, &status);
-        sender_rank = status.MPI_SOURCE;
-
-        /* verificam daca fisierul nu exista si il adaugam in caz afirmativ
-        daca nu exista mentinem indexul curent pt a fi suprascris data viitoare */
-        found_index = find_file_index(cur_file->filename);
-        if (found_index == NOT_FOUND) {
-            found_index = cur_index;
-            nr_files++;
-            cur_index++;
+    int total = 0;
+    if (shard == TRACKER_RANK) {
+        for (int r = 0; r < numtasks; r++) {
+            displs[r] = total;
+            total += lens[r];
+        }
+        buf.resize(total);
+    }
+
+    MPI_Gatherv(nullptr, 0, MPI_BYTE, buf.data(), lens.data(), displs.data(), MPI_BYTE,
+                TRACKER_RANK, MPI_COMM_WORLD);
+
+    if (shard != TRACKER_RANK) {
+        return;
+    }
+
+    // zona fiecarui client contine fisierele lui serializate unul dupa altul
+    file_data cur_file;
+    for (int r = nr_shards; r < numtasks; r++) {
+        int offset = displs[r];
+        while (offset < displs[r] + lens[r]) {
+            offset += unpack_file_data(buf.data() + offset, cur_file);
+
+            // verificam daca fisierul nu exista si il adaugam in caz afirmativ
+            int found_index = find_file_index(cur_file.filename);
+            if (found_index == NOT_FOUND) {
+                found_index = add_swarm(cur_file);
+            }
+            set_owner_state(found_index, r, OWNER_SEED);
         }
+    }
+}
 
-        sw = &(swarms[found_index]);
-        sw->owners.is_seed[sender_rank] = true; 
+/* pasul 2: tabela de id-uri (numele fisierului cu id-ul i e pe pozitia i) ajunge la toate
+rank-urile printr-un MPI_Bcast, care e si semnalul de start pentru clienti */
+void TrackerManager::broadcast_file_ids() {
+    int nr_ids = nr_files;
+    MPI_Bcast(&nr_ids, 1, MPI_INT, TRACKER_RANK, MPI_COMM_WORLD);
+
+    vector<char> names(nr_ids * MAX_FILENAME, 0);
+    if (shard == TRACKER_RANK) {
+        for (int i = 0; i < nr_files; i++) {
+            memcpy(names.data() + i * MAX_FILENAME, swarms[i].file_metadata.filename, MAX_FILENAME);
+        }
     }
+    MPI_Bcast(names.data(), names.size(), MPI_CHAR, TRACKER_RANK, MPI_COMM_WORLD);
 }
 
-// semnaleaza clientilor sa inceapa dupa partea de initializare
-void TrackerManager::signal_clients_to_start() {
-    for (int rank = 1; rank < numtasks; rank++) {
-        MPI_Send(nullptr, 0, MPI_CHAR, rank, MSG_CLIENT_READY_DOWNLOAD, MPI_COMM_WORLD);
-        MPI_Send(nullptr, 0, MPI_CHAR, rank, MSG_CLIENT_READY_UPLOAD, MPI_COMM_WORLD);
+/* pasul 3: fiecare shard isi primeste swarm-urile ([swarm_data ...], in ordinea id-urilor)
+printr-un MPI_Scatterv pe comunicatorul tracker-elor; si cel principal le pastreaza doar pe ale sale */
+void TrackerManager::distribute_swarms() {
+    vector<char> send_buf, buf;
+    vector<int> lens(nr_shards, 0), displs(nr_shards, 0);
+
+    if (shard == TRACKER_RANK) {
+        for (int s = 0; s < nr_shards; s++) {
+            displs[s] = send_buf.size();
+            for (int id = s; id < nr_files; id += nr_shards) {
+                pack_swarm_data(swarms[id], send_buf);
+            }
+            lens[s] = send_buf.size() - displs[s];
+        }
+    }
+
+    int len;
+    MPI_Scatter(lens.data(), 1, MPI_INT, &len, 1, MPI_INT, TRACKER_RANK, tracker_comm);
+    buf.resize(len);
+    MPI_Scatterv(send_buf.data(), lens.data(), displs.data(), MPI_BYTE, buf.data(), len, MPI_BYTE,
+                 TRACKER_RANK, tracker_comm);
+
+    swarms.clear();
+    history.clear();
+    for (int offset = 0; offset < len; ) {
+        swarms.emplace_back();
+        offset += unpack_swarm_data(buf.data() + offset, swarms.back());
+
+        // istoricul incepe de la versiunea primita
+        history.emplace_back();
+        history.back().base_version = swarms.back().owners.version;
     }
+    nr_files = swarms.size();
+    init_push_state();
 }
 
 // loop-ul principal care asteapta mesaje de la clienti
@@ -88,8 +359,19 @@ void tracker_main_loop(TrackerManager& tm) {
 
     while (!finished) {
         MPI_Status status;
-        // asteapta orice mesaj de la orice sursa
-        MPI_Probe(MPI_ANY_SOURCE, MPI_ANY_TAG, MPI_COMM_WORLD, &status);
+        if (tm.push_pending()) {
+            // cu notificari de trimis nu ne blocam, ca ele sa plece la timp
+            int flag;
+            MPI_Iprobe(MPI_ANY_SOURCE, MPI_ANY_TAG, MPI_COMM_WORLD, &flag, &status);
+            if (!flag) {
+                tm.flush_pushes();
+                usleep(100);
+                continue;
+            }
+        } else {
+            // asteapta orice mesaj de la orice sursa
+            MPI_Probe(MPI_ANY_SOURCE, MPI_ANY_TAG, MPI_COMM_WORLD, &status);
+        }
 
         int tag = status.MPI_TAG;
         int source = status.MPI_SOURCE;
@@ -97,64 +379,68 @@ void tracker_main_loop(TrackerManager& tm) {
         // actionam in functie de tag
         switch(tag) {
             case MSG_REQ_FULL_SWARM: {
-                char filename[MAX_FILENAME];
-                MPI_Recv(filename, MAX_FILENAME, MPI_CHAR, source, MSG_REQ_FULL_SWARM, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
-
-                int idx = tm.find_file_index(filename);
-                if (idx == NOT_FOUND) {
-                    // daca nu exista fisierul, trimitem un mesaj gol
-                    swarm_data empty;
-                    memset(&empty, 0, sizeof(swarm_data));
-                    MPI_Send(&empty, sizeof(swarm_data), MPI_BYTE, source, MSG_SWARM_DATA, MPI_COMM_WORLD);
-                } else {
-                    // altfel trimitem swarm-ul corespunzator (hash-uri, nr_chunks, cine are ce)
-                    MPI_Send(&(tm.swarms[idx]), sizeof(swarm_data), MPI_BYTE, source, MSG_SWARM_DATA, MPI_COMM_WORLD);
-
-                    // marcam sursa ca peer pentru acel fisier
-                    tm.swarms[idx].owners.is_peer[source] = true;
+                stat_timer timer(OP_TRACKER_FULL_SWARM);
+                int file_id;
+                MPI_Recv(&file_id, sizeof(int), MPI_BYTE, source, MSG_REQ_FULL_SWARM, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+
+                // daca nu exista fisierul, se trimite un swarm gol
+                int idx = tm.local_index(file_id);
+                tm.send_swarm_data(idx, source);
+
+                // marcam sursa ca peer pentru acel fisier, de acum ii trimitem schimbarile
+                if (idx != NOT_FOUND) {
+                    tm.set_owner_state(idx, source, tm.owner_state(idx, source) | OWNER_PEER);
+                    tm.subscribe(idx, source);
+                    tm.mark_dirty(idx);
                 }
                 break;
             }
 
             case MSG_REQ_UPDATE_SWARM: {
-                char filename[MAX_FILENAME];
-                MPI_Recv(filename, MAX_FILENAME, MPI_CHAR, source, MSG_REQ_UPDATE_SWARM, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
-
-                // cautam index-ul fisierului si trimitem update-ul corespunzator
-                int idx = tm.find_file_index(filename);
-                if (idx == NOT_FOUND) {
-                    swarm_update empty;
-                    memset(&empty, 0, sizeof(swarm_update));
-                    MPI_Send(&empty, sizeof(swarm_update), MPI_BYTE, source, MSG_UPDATE_SWARM, MPI_COMM_WORLD);
-                } else {
-                    MPI_Send(&(tm.swarms[idx].owners), sizeof(swarm_update), MPI_BYTE, source, MSG_UPDATE_SWARM, MPI_COMM_WORLD);
-                }
+                stat_timer timer(OP_TRACKER_UPDATE_SWARM);
+                swarm_update_request req;
+                MPI_Recv(&req, sizeof(swarm_update_request), MPI_BYTE, source, MSG_REQ_UPDATE_SWARM, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+
+                // trimitem doar ce s-a schimbat
+                int idx = tm.local_index(req.file_id);
+                tm.send_swarm_update(idx, source, req.version);
                 break;
             }
 
             // un peer a terminat de descarcat un fisier
             case MSG_FILE_DONE: {
-                char filename[MAX_FILENAME];
-                MPI_Recv(filename, MAX_FILENAME, MPI_CHAR, source, MSG_FILE_DONE, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+                stat_timer timer(OP_TRACKER_FILE_DONE);
+                int file_id;
+                MPI_Recv(&file_id, sizeof(int), MPI_BYTE, source, MSG_FILE_DONE, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
 
-                int idx = tm.find_file_index(filename);
+                int idx = tm.local_index(file_id);
                 if (idx != NOT_FOUND) {
-                    // il facem seed
-                    tm.swarms[idx].owners.is_seed[source] = true;
-                    tm.swarms[idx].owners.is_peer[source] = false;
+                    // il facem seed, iar ceilalti afla imediat
+                    tm.set_owner_state(idx, source, OWNER_SEED);
+                    tm.unsubscribe(idx, source);
+                    tm.mark_dirty(idx);
                 }
                 break;
             }
 
-            // un peer a terminat toate descarcarile
+            /* un peer a terminat toate descarcarile; il anunta pe fiecare shard dupa ultimul lui
+            FILE_DONE, deci un shard care a primit ALL_DONE de la toti nu mai primeste nimic */
             case MSG_ALL_DONE: {
-                MPI_Recv(nullptr, 0, MPI_CHAR, source, MSG_ALL_DONE, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+                stat_timer timer(OP_TRACKER_ALL_DONE);
+                MPI_Recv(nullptr, 0, MPI_BYTE, source, MSG_ALL_DONE, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
                 nr_done_clients++;
 
-                // daca toti au terminat trimitem mesaje de stop
-                if (nr_done_clients == (tm.numtasks - 1)) {
-                    for (int rank = 1; rank < tm.numtasks; rank++) {
-                        MPI_Send(nullptr, 0, MPI_CHAR, rank, MSG_TRACKER_STOP, MPI_COMM_WORLD);
+                // ultima notificare: dupa ea peer-ul stie ca nu mai primeste nimic de la noi
+                if (config.swarm_push) {
+                    MPI_Send(nullptr, 0, MPI_BYTE, source, MSG_SWARM_PUSH, MPI_COMM_WORLD);
+                }
+
+                if (nr_done_clients == (tm.numtasks - tm.nr_shards)) {
+                    // tracker-ul principal opreste si thread-urile de upload
+                    if (tm.shard == TRACKER_RANK) {
+                        for (int rank = tm.nr_shards; rank < tm.numtasks; rank++) {
+                            tm.transport->send(nullptr, 0, rank, MSG_TRACKER_STOP);
+                        }
                     }
                     finished = true;
                 }
@@ -162,22 +448,32 @@ void tracker_main_loop(TrackerManager& tm) {
             }
 
             default: {
-                MPI_Recv(nullptr, 0, MPI_CHAR, source, tag, MPI_COMM_WORLD, &status);
+                MPI_Recv(nullptr, 0, MPI_BYTE, source, tag, MPI_COMM_WORLD, &status);
                 cerr << "[Tracker] Unknown tag " << tag << " from peer " << source << endl;
                 break;
             }
         }
+
+        // un mesaj care asteapta deja inseamna ca tracker-ul e in urma
+        int pending;
+        MPI_Iprobe(MPI_ANY_SOURCE, MPI_ANY_TAG, MPI_COMM_WORLD, &pending, MPI_STATUS_IGNORE);
+        stat_add(CNT_TRACKER_MSGS, 1);
+        stat_add(CNT_TRACKER_BUSY, pending);
+        tm.flush_pushes();
     }
+
+    tm.finish_pushes();
 }
 
 void tracker(int numtasks, int rank) {
-    TrackerManager tm(numtasks);
-
-    tm.receive_nr_files_to_process();
-    tm.receive_all_initial_files_data();
+    uint64_t start_ns = stat_now_ns();
+    TrackerManager tm(numtasks, rank);
 
-    // semnaleaza clientilor sa inceapa
-    tm.signal_clients_to_start();
+    // inregistrarea se face la tracker-ul principal, care apoi imparte swarm-urile
+    tm.receive_initial_files();
+    tm.broadcast_file_ids();
+    tm.distribute_swarms();
+    stat_add(CNT_INIT_US, (stat_now_ns() - start_ns) / 1000);
 
     // logica principala (swarm-uri si update-uri)
     tracker_main_loop(tm);
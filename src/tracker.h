@@ -1,22 +1,74 @@
 #pragma once
 
+#include <mpi.h>
+#include <stdint.h>
+#include <string>
+#include <unordered_map>
+#include <vector>
 #include "struct.h"
+#include "transport.h"
 
+// ultimele schimbari din swarm, acopera versiunile (base_version, owners.version]
+struct swarm_history {
+    int base_version;
+    std::vector<swarm_change> changes;
+};
+
+// o notificare trimisa tuturor abonatilor unui swarm; buffer-ul traieste pana se termina Isend-urile
+struct push_batch {
+    std::vector<char> buf;
+    std::vector<MPI_Request> reqs;
+};
+
+/* swarm-urile sunt impartite intre tracker-e dupa id: fisierul cu id-ul "id" e tinut de
+shard-ul id % nr_shards, la indexul local id / nr_shards */
 class TrackerManager {
 public:
     int numtasks;
-    int nr_files;            // cate fisiere exista in total
-    int nr_initial_files;    // cate fisiere vor fi procesate initial (pot exista dubluri)
-    swarm_data swarms[MAX_FILES]; 
+    int shard;               // rank-ul acestui tracker
+    int nr_shards;           // cate tracker-e sunt (rank-urile 0 .. nr_shards - 1)
+    int nr_files;            // cate fisiere tine acest shard (la inregistrare, toate)
+    Transport* transport;    // canalul thread-urilor de upload (aici doar pentru stop)
+    MPI_Comm tracker_comm;   // doar tracker-ele, pentru impartirea swarm-urilor
+    std::vector<swarm_data> swarms; // cate un swarm pentru fiecare fisier cunoscut
+    std::vector<swarm_history> history;
+    // id-ul unui fisier e indexul swarm-ului lui, numele apar doar la inregistrare
+    std::unordered_map<std::string, int> file_ids;
+
+    // abonatii unui swarm (peerii care descarca fisierul) primesc schimbarile fara sa le ceara
+    std::vector<std::vector<int>> subscribers;
+    std::vector<int> pushed_version;   // versiunea pana la care abonatii au primit schimbarile
+    std::vector<uint64_t> last_push_ns;
+    std::vector<int> dirty;            // swarm-urile cu schimbari netrimise inca
+    std::vector<char> is_dirty;
+    std::vector<push_batch> batches;   // notificarile in curs
+    int nr_push_inflight;
 
-    TrackerManager(int numtasks);
+    TrackerManager(int numtasks, int rank);
+    ~TrackerManager();
 
     int find_file_index(const char* filename);
+    int local_index(int file_id);
+    int add_swarm(const file_data& file);
+    int owner_state(int idx, int rank);
+    void set_owner_state(int idx, int rank, int state);
+    void send_swarm_data(int idx, int dest);
+    void build_swarm_update(int idx, int since_version, std::vector<char>& buf);
+    void send_swarm_update(int idx, int dest, int since_version);
+
+    // notificari catre abonati
+    void init_push_state();
+    void subscribe(int idx, int rank);
+    void unsubscribe(int idx, int rank);
+    void mark_dirty(int idx);
+    bool push_pending();
+    void flush_pushes();
+    void finish_pushes();
 
-    // functii de initializare
-    void receive_nr_files_to_process();
-    void receive_all_initial_files_data();
-    void signal_clients_to_start();
+    // functii de initializare (colective)
+    void receive_initial_files();
+    void broadcast_file_ids();
+    void distribute_swarms();
 };
 
 void tracker_main_loop(TrackerManager& tm);
@@ -0,0 +1,780 @@
+#include <mpi.h>
+#include <sched.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+#include <time.h>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <new>
+#include <vector>
+#include <algorithm>
+#include "struct.h"
+#include "transport.h"
+
+using namespace std;
+
+uint64_t xfer_now_ns() {
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+MpiTransport::MpiTransport(MPI_Comm comm, bool owned) : comm(comm), owned(owned) {}
+
+MpiTransport::~MpiTransport() {
+    if (owned) {
+        MPI_Comm_free(&comm);
+    }
+}
+
+void MpiTransport::isend(const void* buf, int len, int dest, int tag, xfer_request& req) {
+    MPI_Isend(buf, len, MPI_BYTE, dest, tag, comm, &req.mpi);
+    req.persistent = false;
+    req.store_state(XFER_ACTIVE);
+}
+
+void MpiTransport::send(const void* buf, int len, int dest, int tag) {
+    MPI_Send(buf, len, MPI_BYTE, dest, tag, comm);
+}
+
+void MpiTransport::irecv(void* buf, int len, int source, int tag, xfer_request& req) {
+    MPI_Irecv(buf, len, MPI_BYTE, source == XFER_ANY_SOURCE ? MPI_ANY_SOURCE : source, tag, comm, &req.mpi);
+    req.persistent = false;
+    req.store_state(XFER_ACTIVE);
+}
+
+/* dimensiunea se afla abia cand soseste mesajul, deci receive-ul e doar notat aici; wait il
+primeste cu MPI_Mprobe + MPI_Mrecv, iar test cu MPI_Improbe */
+void MpiTransport::irecv_packed(vector<char>& buf, int source, int tag, xfer_request& req) {
+    req.packed = &buf;
+    req.source = source == XFER_ANY_SOURCE ? MPI_ANY_SOURCE : source;
+    req.tag = tag;
+    req.mpi = MPI_REQUEST_NULL;
+    req.persistent = false;
+    req.store_state(XFER_ACTIVE);
+}
+
+// primeste mesajul gasit de probe in vectorul receive-ului
+static void receive_matched(xfer_request& req, MPI_Message& msg, MPI_Status& probe_status, xfer_status* status) {
+    int len;
+    MPI_Get_count(&probe_status, MPI_BYTE, &len);
+    req.packed->resize(len);
+    MPI_Mrecv(req.packed->data(), len, MPI_BYTE, &msg, MPI_STATUS_IGNORE);
+
+    req.packed = nullptr;
+    req.store_state(XFER_NULL);
+    if (status != nullptr) {
+        *status = {probe_status.MPI_SOURCE, len};
+    }
+}
+
+void MpiTransport::recv_init(void* buf, int len, int source, int tag, xfer_request& req) {
+    MPI_Recv_init(buf, len, MPI_BYTE, source == XFER_ANY_SOURCE ? MPI_ANY_SOURCE : source, tag, comm, &req.mpi);
+    req.persistent = true;
+    req.store_state(XFER_INACTIVE);
+}
+
+void MpiTransport::start(xfer_request& req) {
+    MPI_Start(&req.mpi);
+    req.store_state(XFER_ACTIVE);
+}
+
+// un receive de dimensiune necunoscuta nu e postat inainte de wait, deci e mereu anulat
+bool MpiTransport::cancel(xfer_request& req) {
+    bool cancelled = req.load_state() == XFER_ACTIVE;
+    if (cancelled && req.packed == nullptr) {
+        MPI_Status status;
+        int flag;
+        MPI_Cancel(&req.mpi);
+        MPI_Wait(&req.mpi, &status);
+        MPI_Test_cancelled(&status, &flag);
+        cancelled = flag;
+    }
+    if (req.persistent) {
+        MPI_Request_free(&req.mpi);
+    }
+    req.packed = nullptr;
+    req.persistent = false;
+    req.store_state(XFER_NULL);
+    return cancelled;
+}
+
+void MpiTransport::wait(xfer_request& req, xfer_status* status) {
+    if (!req.active()) {
+        if (status != nullptr) {
+            *status = {XFER_ANY_SOURCE, 0};
+        }
+        return;
+    }
+
+    MPI_Status mpi_status;
+    if (req.packed != nullptr) {
+        MPI_Message msg;
+        MPI_Mprobe(req.source, req.tag, comm, &msg, &mpi_status);
+        receive_matched(req, msg, mpi_status, status);
+        return;
+    }
+
+    MPI_Wait(&req.mpi, &mpi_status);
+    req.store_state(req.persistent ? XFER_INACTIVE : XFER_NULL);
+    if (status != nullptr) {
+        status->source = mpi_status.MPI_SOURCE;
+        MPI_Get_count(&mpi_status, MPI_BYTE, &status->count);
+    }
+}
+
+bool MpiTransport::test(xfer_request& req, xfer_status* status) {
+    if (!req.active()) {
+        return false;
+    }
+
+    int flag;
+    MPI_Status mpi_status;
+    if (req.packed != nullptr) {
+        MPI_Message msg;
+        MPI_Improbe(req.source, req.tag, comm, &flag, &msg, &mpi_status);
+        if (flag) {
+            receive_matched(req, msg, mpi_status, status);
+        }
+        return flag;
+    }
+
+    MPI_Test(&req.mpi, &flag, &mpi_status);
+    if (flag) {
+        req.store_state(req.persistent ? XFER_INACTIVE : XFER_NULL);
+        if (status != nullptr) {
+            status->source = mpi_status.MPI_SOURCE;
+            MPI_Get_count(&mpi_status, MPI_BYTE, &status->count);
+        }
+    }
+    return flag;
+}
+
+/* MPI nu are un wait cu limita de timp; MPI_Wait verifica oricum progresul in bucla, deci facem
+la fel, cedand procesorul intre verificari */
+bool MpiTransport::wait_for(xfer_request& req, int timeout_ms, xfer_status* status) {
+    uint64_t deadline_ns = xfer_now_ns() + (uint64_t)timeout_ms * 1000000;
+    while (!test(req, status)) {
+        if (!req.active() || xfer_now_ns() >= deadline_ns) {
+            return false;
+        }
+        sched_yield();
+    }
+    return true;
+}
+
+void MpiTransport::waitsome(int n, xfer_request* reqs, int& nr_done, int* indices, xfer_status* statuses) {
+    // fiecare thread isi refoloseste vectorii, waitsome e pe drumul fiecarui raspuns
+    thread_local vector<MPI_Request> mpi_reqs;
+    thread_local vector<MPI_Status> mpi_statuses;
+    mpi_reqs.resize(n);
+    mpi_statuses.resize(n);
+
+    // un receive persistent neinceput e ignorat, ca MPI_REQUEST_NULL
+    for (int i = 0; i < n; i++) {
+        mpi_reqs[i] = reqs[i].active() ? reqs[i].mpi : MPI_REQUEST_NULL;
+    }
+
+    MPI_Waitsome(n, mpi_reqs.data(), &nr_done, indices, mpi_statuses.data());
+    if (nr_done == MPI_UNDEFINED) {
+        nr_done = 0;
+        return;
+    }
+
+    for (int i = 0; i < n; i++) {
+        if (reqs[i].active()) {
+            reqs[i].mpi = mpi_reqs[i];
+        }
+    }
+    for (int d = 0; d < nr_done; d++) {
+        xfer_request& req = reqs[indices[d]];
+        req.store_state(req.persistent ? XFER_INACTIVE : XFER_NULL);
+        statuses[d].source = mpi_statuses[d].MPI_SOURCE;
+        MPI_Get_count(&mpi_statuses[d], MPI_BYTE, &statuses[d].count);
+    }
+}
+
+/* segmentul partajat: un antet, apoi cate un inel pentru fiecare (rank, canal). Un inel are
+nr_cells celule de SHM_CELL_SIZE octeti si un numar de secventa per celula (coada marginita a
+lui Vyukov, cu rezervari de mai multe celule): celula de la pozitia p e libera pentru un
+producator cand seq == p, iar mesajul care incepe la p e gata pentru consumator cand seq == p + 1.
+Un mesaj ocupa celule consecutive ([shm_msg_header][date]), iar consumatorul le elibereaza in
+ordine, deci ultima celula libera a unei rezervari inseamna ca toate sunt libere. Un mesaj mai
+lung de SHM_FRAGMENT_BYTES e impartit in fragmente consecutive (offset/total in antet); fiecare
+sursa are un singur thread producator pe un canal, deci fragmentele ei nu se intercaleaza */
+
+#define SHM_MAGIC 0x74656d6132736d68ull
+// cate verificari (cu sched_yield) face consumatorul inainte sa adoarma pe futex
+#define SHM_SPIN 64
+// cat doarme cel mult, ca plasa de siguranta pentru o trezire pierduta
+#define SHM_SLEEP_NS 10000000
+
+struct shm_segment_header {
+    uint64_t magic;
+    uint64_t nr_cells;
+    int nr_ranks;
+};
+
+// coada si cuvantul futex al consumatorului stau pe linii de cache separate
+struct shm_ring_header {
+    alignas(64) atomic<uint64_t> tail;
+    alignas(64) atomic<uint32_t> wake_seq;
+    atomic<uint32_t> sleeping;
+};
+
+struct shm_ring {
+    shm_ring_header* header;
+    atomic<uint64_t>* seq;
+    char* data;
+};
+
+struct shm_msg_header {
+    int source;
+    int tag;
+    int len; // al fragmentului
+    int nr_cells;
+    int total; // al mesajului intreg
+    int offset;
+};
+
+// cel mult atatia octeti de date intr-un fragment, antetul ocupand prima celula
+static const int SHM_FRAGMENT_DATA = SHM_FRAGMENT_BYTES - SHM_CELL_SIZE;
+
+static const size_t SHM_SEGMENT_HEADER_SIZE = 64;
+
+static int channel_for(int tag) {
+    return tag >= MSG_CHUNK_RESPONSE ? SHM_CHANNEL_DOWNLOAD : SHM_CHANNEL_UPLOAD;
+}
+
+static uint64_t cells_for(int len) {
+    return (sizeof(shm_msg_header) + len + SHM_CELL_SIZE - 1) / SHM_CELL_SIZE;
+}
+
+static size_t ring_stride(uint64_t nr_cells) {
+    return sizeof(shm_ring_header) + nr_cells * (sizeof(uint64_t) + SHM_CELL_SIZE);
+}
+
+// futex intre procese (fara FUTEX_PRIVATE_FLAG), pe un cuvant din segment
+static void futex_wait(atomic<uint32_t>* word, uint32_t value, long timeout_ns) {
+    timespec timeout = {0, timeout_ns};
+    syscall(SYS_futex, reinterpret_cast<uint32_t*>(word), FUTEX_WAIT, value, &timeout, nullptr, 0);
+}
+
+static void futex_wake(atomic<uint32_t>* word) {
+    syscall(SYS_futex, reinterpret_cast<uint32_t*>(word), FUTEX_WAKE, 1, nullptr, nullptr, 0);
+}
+
+ShmTransport::ShmTransport(int rank, int numtasks)
+    : rank(rank), numtasks(numtasks), base(nullptr), size(0), nr_cells(0) {
+    for (channel& c : channels) {
+        c.head = 0;
+        c.partials.resize(numtasks);
+        for (partial& p : c.partials) {
+            p.match = nullptr;
+            p.dst = nullptr;
+        }
+    }
+}
+
+ShmTransport::~ShmTransport() {
+    if (base != nullptr) {
+        munmap(base, size);
+    }
+}
+
+shm_ring ShmTransport::ring(int r, int ch) {
+    char* start = base + SHM_SEGMENT_HEADER_SIZE + (size_t)(r * SHM_NR_CHANNELS + ch) * ring_stride(nr_cells);
+    shm_ring ring;
+    ring.header = reinterpret_cast<shm_ring_header*>(start);
+    ring.seq = reinterpret_cast<atomic<uint64_t>*>(start + sizeof(shm_ring_header));
+    ring.data = start + sizeof(shm_ring_header) + nr_cells * sizeof(uint64_t);
+    return ring;
+}
+
+/* colectiv: rank-ul 0 creeaza si initializeaza segmentul (rezervat complet cu posix_fallocate,
+ca lipsa memoriei sa apara aici si nu ca SIGBUS mai tarziu), ceilalti il mapeaza dupa nume;
+numele e sters imediat ce l-au deschis toti, deci segmentul dispare odata cu procesele */
+bool ShmTransport::open(int max_msg) {
+    struct {
+        char name[64];
+        uint64_t nr_cells;
+        int ok;
+    } info;
+    memset(&info, 0, sizeof(info));
+    int fd = -1;
+
+    auto map = [&]() {
+        size = SHM_SEGMENT_HEADER_SIZE + (size_t)numtasks * SHM_NR_CHANNELS * ring_stride(nr_cells);
+        void* data = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        base = data == MAP_FAILED ? nullptr : static_cast<char*>(data);
+        return base != nullptr;
+    };
+
+    if (rank == 0) {
+        uint64_t min_cells = max((uint64_t)SHM_RING_MIN_BYTES / SHM_CELL_SIZE,
+                                 SHM_RING_MIN_MESSAGES * cells_for(min(max(max_msg, 0), SHM_FRAGMENT_DATA)));
+        for (nr_cells = 1; nr_cells < min_cells; nr_cells <<= 1) {
+        }
+
+        snprintf(info.name, sizeof(info.name), "/tema2_%d_%lx", (int)getpid(), (long)time(nullptr));
+        info.nr_cells = nr_cells;
+        fd = shm_open(info.name, O_CREAT | O_EXCL | O_RDWR, 0600);
+        size = SHM_SEGMENT_HEADER_SIZE + (size_t)numtasks * SHM_NR_CHANNELS * ring_stride(nr_cells);
+        info.ok = fd >= 0 && posix_fallocate(fd, 0, size) == 0 && map();
+
+        if (info.ok) {
+            shm_segment_header* header = reinterpret_cast<shm_segment_header*>(base);
+            header->magic = SHM_MAGIC;
+            header->nr_cells = nr_cells;
+            header->nr_ranks = numtasks;
+
+            for (int r = 0; r < numtasks; r++) {
+                for (int ch = 0; ch < SHM_NR_CHANNELS; ch++) {
+                    shm_ring rg = ring(r, ch);
+                    new (&rg.header->tail) atomic<uint64_t>(0);
+                    new (&rg.header->wake_seq) atomic<uint32_t>(0);
+                    new (&rg.header->sleeping) atomic<uint32_t>(0);
+                    for (uint64_t i = 0; i < nr_cells; i++) {
+                        new (&rg.seq[i]) atomic<uint64_t>(i);
+                    }
+                }
+            }
+            atomic_thread_fence(memory_order_seq_cst);
+        }
+    }
+
+    MPI_Bcast(&info, sizeof(info), MPI_BYTE, 0, MPI_COMM_WORLD);
+
+    int ok = info.ok;
+    if (ok && rank != 0) {
+        nr_cells = info.nr_cells;
+        fd = shm_open(info.name, O_RDWR, 0600);
+        ok = fd >= 0 && map()
+             && reinterpret_cast<shm_segment_header*>(base)->magic == SHM_MAGIC;
+    }
+
+    int all_ok;
+    MPI_Allreduce(&ok, &all_ok, 1, MPI_INT, MPI_LAND, MPI_COMM_WORLD);
+
+    if (rank == 0 && fd >= 0) {
+        shm_unlink(info.name);
+    }
+    if (fd >= 0) {
+        close(fd);
+    }
+    if (!all_ok && base != nullptr) {
+        munmap(base, size);
+        base = nullptr;
+    }
+    return all_ok;
+}
+
+// rezerva celulele fragmentului in inelul destinatiei si il publica; false daca inelul e plin
+bool ShmTransport::try_push(int dest, int tag, const void* buf, int len, int total, int offset) {
+    shm_ring rg = ring(dest, channel_for(tag));
+    uint64_t mask = nr_cells - 1;
+    uint64_t nr = cells_for(len);
+    uint64_t pos = rg.header->tail.load(memory_order_relaxed);
+
+    while (true) {
+        uint64_t last = pos + nr - 1;
+        uint64_t seq = rg.seq[last & mask].load(memory_order_acquire);
+        if (seq == last) {
+            if (rg.header->tail.compare_exchange_weak(pos, pos + nr, memory_order_relaxed)) {
+                break;
+            }
+        } else if ((int64_t)(seq - last) < 0) {
+            return false;
+        } else {
+            pos = rg.header->tail.load(memory_order_relaxed);
+        }
+    }
+
+    // antetul e in prima celula, datele continua dupa el si pot trece peste capatul inelului
+    shm_msg_header header = {rank, tag, len, (int)nr, total, offset};
+    size_t ring_bytes = nr_cells * SHM_CELL_SIZE;
+    size_t at = (pos & mask) * SHM_CELL_SIZE;
+    memcpy(rg.data + at, &header, sizeof(header));
+
+    at += sizeof(header);
+    size_t first = min((size_t)len, ring_bytes - at);
+    if (first > 0) {
+        memcpy(rg.data + at, buf, first);
+    }
+    if ((size_t)len > first) {
+        memcpy(rg.data, static_cast<const char*>(buf) + first, len - first);
+    }
+
+    rg.seq[pos & mask].store(pos + 1, memory_order_release);
+
+    // consumatorul anunta ca doarme inainte sa verifice ultima data inelul (vezi sleep_until_ready)
+    atomic_thread_fence(memory_order_seq_cst);
+    if (rg.header->sleeping.load(memory_order_relaxed)) {
+        rg.header->wake_seq.fetch_add(1, memory_order_release);
+        futex_wake(&rg.header->wake_seq);
+    }
+    return true;
+}
+
+/* cat timp inelul destinatiei e plin golim canalul pe care il consumam noi (celalalt), ca doi
+peeri care isi trimit unul altuia in acelasi timp sa nu se astepte la nesfarsit */
+void ShmTransport::push(int dest, int tag, const void* buf, int len) {
+    int own = SHM_NR_CHANNELS - 1 - channel_for(tag);
+    const char* data = static_cast<const char*>(buf);
+    int offset = 0;
+
+    do {
+        int fragment = min(len - offset, SHM_FRAGMENT_DATA);
+        while (!try_push(dest, tag, data + offset, fragment, len, offset)) {
+            progress(own);
+            sched_yield();
+        }
+        offset += fragment;
+    } while (offset < len);
+}
+
+// ca MPI_ERR_TRUNCATE: un mesaj mai lung decat receive-ul ar pierde octeti fara sa stie cineva
+void ShmTransport::truncated(int len, int posted_len) const {
+    // poate fi un thread de lucru, care nu are voie sa apeleze MPI (MPI_THREAD_FUNNELED)
+    cerr << "[Rank " << rank << "] Message of " << len << " bytes is longer than the posted receive ("
+         << posted_len << " bytes)" << endl;
+    exit(-1);
+}
+
+void ShmTransport::complete(xfer_request& req, int source, int count) {
+    req.packed = nullptr;
+    req.status.source = source;
+    req.status.count = count;
+    req.store_state(XFER_DONE);
+}
+
+void ShmTransport::collect(xfer_request& req, xfer_status* status) {
+    if (status != nullptr) {
+        *status = req.status;
+    }
+    req.store_state(req.persistent ? XFER_INACTIVE : XFER_NULL);
+}
+
+/* scoate un fragment din inelul nostru. Primul fragment al unui mesaj alege destinatia: primul
+receive postat care i se potriveste (ca in MPI, dupa sursa si tag, in ordinea postarii), sau un
+buffer care ajunge in lista celor neasteptate cand mesajul e complet */
+bool ShmTransport::pop(int ch) {
+    channel& c = channels[ch];
+    shm_ring rg = ring(rank, ch);
+    uint64_t mask = nr_cells - 1;
+
+    if (rg.seq[c.head & mask].load(memory_order_acquire) != c.head + 1) {
+        return false;
+    }
+
+    shm_msg_header header;
+    size_t ring_bytes = nr_cells * SHM_CELL_SIZE;
+    size_t offset = (c.head & mask) * SHM_CELL_SIZE;
+    memcpy(&header, rg.data + offset, sizeof(header));
+    offset += sizeof(header);
+
+    partial& p = c.partials[header.source];
+    if (header.offset == 0) {
+        p.match = nullptr;
+        for (size_t i = 0; i < c.posted.size(); i++) {
+            xfer_request* req = c.posted[i];
+            if ((req->source == XFER_ANY_SOURCE || req->source == header.source) && req->tag == header.tag) {
+                p.match = req;
+                c.posted.erase(c.posted.begin() + i);
+                break;
+            }
+        }
+
+        if (p.match != nullptr && p.match->packed != nullptr) {
+            p.match->packed->resize(header.total);
+            p.dst = p.match->packed->data();
+        } else if (p.match != nullptr) {
+            if (header.total > p.match->len) {
+                truncated(header.total, p.match->len);
+            }
+            p.dst = static_cast<char*>(p.match->buf);
+        } else {
+            p.data.resize(header.total);
+            p.dst = p.data.data();
+        }
+        p.total = header.total;
+        p.received = 0;
+    }
+
+    char* dst = p.dst + header.offset;
+    int len = header.len;
+    size_t first = min((size_t)len, ring_bytes - offset);
+    if (first > 0) {
+        memcpy(dst, rg.data + offset, first);
+    }
+    if ((size_t)len > first) {
+        memcpy(dst + first, rg.data, len - first);
+    }
+
+    // celulele se elibereaza in ordine, pentru urmatoarea tura a inelului
+    for (int i = 0; i < header.nr_cells; i++) {
+        rg.seq[(c.head + i) & mask].store(c.head + i + nr_cells, memory_order_release);
+    }
+    c.head += header.nr_cells;
+
+    p.received += len;
+    if (p.received == p.total) {
+        if (p.match != nullptr) {
+            complete(*p.match, header.source, p.total);
+        } else {
+            c.unexpected.push_back({header.source, header.tag, vector<char>()});
+            c.unexpected.back().data.swap(p.data);
+        }
+        p.match = nullptr;
+        p.dst = nullptr;
+    }
+    return true;
+}
+
+// receive-ul primeste chiar acum un mesaj fragmentat
+bool ShmTransport::assembling(int ch, const xfer_request* req) const {
+    for (const partial& p : channels[ch].partials) {
+        if (p.dst != nullptr && p.match == req) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void ShmTransport::progress(int ch) {
+    while (pop(ch)) {
+    }
+}
+
+/* asteapta un mesaj in inelul canalului: intai cateva verificari cedand procesorul, apoi pe
+futex. "sleeping" e scris inaintea ultimei verificari, iar producatorul il citeste dupa ce
+publica, deci cel putin unul dintre ei vede mesajul */
+void ShmTransport::sleep_until_ready(int ch, long timeout_ns) {
+    shm_ring rg = ring(rank, ch);
+    uint64_t mask = nr_cells - 1;
+    uint64_t head = channels[ch].head;
+    auto ready = [&]() {
+        return rg.seq[head & mask].load(memory_order_acquire) == head + 1;
+    };
+
+    for (int i = 0; i < SHM_SPIN; i++) {
+        if (ready()) {
+            return;
+        }
+        sched_yield();
+    }
+
+    uint32_t wake_seq = rg.header->wake_seq.load(memory_order_acquire);
+    rg.header->sleeping.store(1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_seq_cst);
+    if (!ready()) {
+        futex_wait(&rg.header->wake_seq, wake_seq, timeout_ns);
+    }
+    rg.header->sleeping.store(0, memory_order_relaxed);
+}
+
+// mesajul e copiat in inel la trimitere, deci trimiterea e deja completa
+void ShmTransport::isend(const void* buf, int len, int dest, int tag, xfer_request& req) {
+    push(dest, tag, buf, len);
+    req.persistent = false;
+    req.store_state(XFER_NULL);
+}
+
+void ShmTransport::send(const void* buf, int len, int dest, int tag) {
+    push(dest, tag, buf, len);
+}
+
+void ShmTransport::irecv(void* buf, int len, int source, int tag, xfer_request& req) {
+    req.buf = buf;
+    req.len = len;
+    req.source = source;
+    req.tag = tag;
+    req.persistent = false;
+    start(req);
+}
+
+void ShmTransport::irecv_packed(vector<char>& buf, int source, int tag, xfer_request& req) {
+    req.packed = &buf;
+    req.source = source;
+    req.tag = tag;
+    req.persistent = false;
+    start(req);
+}
+
+void ShmTransport::recv_init(void* buf, int len, int source, int tag, xfer_request& req) {
+    req.buf = buf;
+    req.len = len;
+    req.source = source;
+    req.tag = tag;
+    req.persistent = true;
+    req.store_state(XFER_INACTIVE);
+}
+
+// un mesaj sosit deja completeaza receive-ul imediat, altfel acesta asteapta in lista canalului
+void ShmTransport::start(xfer_request& req) {
+    channel& c = channels[channel_for(req.tag)];
+
+    for (auto it = c.unexpected.begin(); it != c.unexpected.end(); it++) {
+        if ((req.source == XFER_ANY_SOURCE || req.source == it->source) && req.tag == it->tag) {
+            int len;
+            if (req.packed != nullptr) {
+                len = it->data.size();
+                req.packed->swap(it->data);
+            } else {
+                len = it->data.size();
+                if (len > req.len) {
+                    truncated(len, req.len);
+                }
+                if (len > 0) {
+                    memcpy(req.buf, it->data.data(), len);
+                }
+            }
+            complete(req, it->source, len);
+            c.unexpected.erase(it);
+            return;
+        }
+    }
+
+    req.store_state(XFER_ACTIVE);
+    c.posted.push_back(&req);
+}
+
+/* receive-urile sunt completate de thread-ul care le-a postat, deci unul activ e inca in "posted",
+sau primeste un mesaj fragmentat, pe care il lasam sa se termine (restul fragmentelor e deja pe
+drum, producatorul nu mai asteapta nimic de la noi) */
+bool ShmTransport::cancel(xfer_request& req) {
+    int ch = channel_for(req.tag);
+    while (assembling(ch, &req)) {
+        progress(ch);
+        sched_yield();
+    }
+    bool cancelled = req.load_state() == XFER_ACTIVE;
+    if (cancelled) {
+        vector<xfer_request*>& posted = channels[ch].posted;
+        posted.erase(remove(posted.begin(), posted.end(), &req), posted.end());
+    }
+    req.packed = nullptr;
+    req.persistent = false;
+    req.store_state(XFER_NULL);
+    return cancelled;
+}
+
+void ShmTransport::wait(xfer_request& req, xfer_status* status) {
+    if (!req.active()) {
+        if (status != nullptr) {
+            *status = {XFER_ANY_SOURCE, 0};
+        }
+        return;
+    }
+
+    int ch = channel_for(req.tag);
+    while (true) {
+        progress(ch);
+        if (req.load_state() == XFER_DONE) {
+            break;
+        }
+        sleep_until_ready(ch, SHM_SLEEP_NS);
+    }
+    collect(req, status);
+}
+
+bool ShmTransport::wait_for(xfer_request& req, int timeout_ms, xfer_status* status) {
+    if (!req.active()) {
+        return false;
+    }
+
+    int ch = channel_for(req.tag);
+    uint64_t deadline_ns = xfer_now_ns() + (uint64_t)timeout_ms * 1000000;
+    while (true) {
+        progress(ch);
+        if (req.load_state() == XFER_DONE) {
+            break;
+        }
+        uint64_t now_ns = xfer_now_ns();
+        if (now_ns >= deadline_ns) {
+            return false;
+        }
+        sleep_until_ready(ch, min(deadline_ns - now_ns, (uint64_t)SHM_SLEEP_NS));
+    }
+    collect(req, status);
+    return true;
+}
+
+bool ShmTransport::test(xfer_request& req, xfer_status* status) {
+    if (!req.active()) {
+        return false;
+    }
+
+    progress(channel_for(req.tag));
+    if (req.load_state() != XFER_DONE) {
+        return false;
+    }
+    collect(req, status);
+    return true;
+}
+
+// receive-urile unui apel sunt ale aceluiasi thread, deci ale aceluiasi canal
+void ShmTransport::waitsome(int n, xfer_request* reqs, int& nr_done, int* indices, xfer_status* statuses) {
+    int ch = NOT_FOUND;
+    for (int i = 0; i < n && ch == NOT_FOUND; i++) {
+        if (reqs[i].active()) {
+            ch = channel_for(reqs[i].tag);
+        }
+    }
+
+    nr_done = 0;
+    if (ch == NOT_FOUND) {
+        return;
+    }
+
+    while (true) {
+        progress(ch);
+        for (int i = 0; i < n; i++) {
+            if (reqs[i].load_state() == XFER_DONE) {
+                indices[nr_done] = i;
+                collect(reqs[i], &statuses[nr_done]);
+                nr_done++;
+            }
+        }
+        if (nr_done > 0) {
+            return;
+        }
+        sleep_until_ready(ch, SHM_SLEEP_NS);
+    }
+}
+
+Transport* create_transport(const char* kind, int max_msg) {
+    int rank, numtasks;
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    MPI_Comm_size(MPI_COMM_WORLD, &numtasks);
+
+    if (strcmp(kind, "mpi") != 0) {
+        // segmentul trebuie sa fie vazut de toate rank-urile
+        MPI_Comm node_comm;
+        int node_size;
+        MPI_Comm_split_type(MPI_COMM_WORLD, MPI_COMM_TYPE_SHARED, rank, MPI_INFO_NULL, &node_comm);
+        MPI_Comm_size(node_comm, &node_size);
+        MPI_Comm_free(&node_comm);
+
+        if (node_size == numtasks) {
+            ShmTransport* shm = new ShmTransport(rank, numtasks);
+            if (shm->open(max_msg)) {
+                return shm;
+            }
+            delete shm;
+        }
+        if (rank == 0 && strcmp(kind, "shm") == 0) {
+            cerr << "Shared-memory transport unavailable, using MPI" << endl;
+        }
+    }
+
+    MPI_Comm comm;
+    MPI_Comm_dup(MPI_COMM_WORLD, &comm);
+    return new MpiTransport(comm, true);
+}
@@ -0,0 +1,207 @@
+#pragma once
+
+#include <mpi.h>
+#include <stdint.h>
+#include <deque>
+#include <vector>
+
+/* cererile si raspunsurile de chunk-uri (cu payload-ul lor) si stop-ul thread-urilor de upload
+trec printr-un transport cu interfata unui subset din MPI punct-la-punct: operatii non-blocante
+terminate de wait/waitsome, cu aceleasi reguli de potrivire dupa sursa si tag. Sunt doua
+implementari: MPI pe un comunicator propriu (oricate noduri) si cozi fara lock-uri in memorie
+partajata, cand toate rank-urile sunt pe acelasi nod. Mesajele cu tracker-ul folosesc aceeasi
+interfata, dar mereu peste MPI_COMM_WORLD; operatiile colective raman apeluri MPI directe */
+
+#define XFER_ANY_SOURCE -1
+
+// starea unei operatii a transportului
+#define XFER_NULL     0 // nimic in curs (ca MPI_REQUEST_NULL)
+#define XFER_ACTIVE   1 // pornita, neterminata
+#define XFER_DONE     2 // terminata, dar inca neraportata de wait/waitsome (doar shm)
+#define XFER_INACTIVE 3 // receive persistent raportat, care poate fi repornit cu start
+
+struct xfer_status {
+    int source;
+    int count; // octetii primiti
+};
+
+/* o operatie a transportului; ca un MPI_Request, sta la aceeasi adresa cat timp e activa,
+pentru ca backend-ul shm tine pointeri la receive-urile postate si le completeaza direct.
+Starea e publicata de motorul de progres din alt thread, asa ca e citita si scrisa doar atomic
+(prin load_state/store_state); restul campurilor sunt vizibile dupa ce starea e citita */
+struct xfer_request {
+    int state = XFER_NULL;
+    bool persistent = false;
+    MPI_Request mpi = MPI_REQUEST_NULL;
+    // receive-ul postat si rezultatul lui (backend-ul shm si thread-ul de comunicatie)
+    void* buf = nullptr;
+    int len = 0;
+    int source = 0;
+    int tag = 0;
+    std::vector<char>* packed = nullptr; // irecv_packed: bufferul ia dimensiunea mesajului
+    xfer_status status = {0, 0};
+
+    int load_state() const {
+        return __atomic_load_n(&state, __ATOMIC_ACQUIRE);
+    }
+    void store_state(int value) {
+        __atomic_store_n(&state, value, __ATOMIC_RELEASE);
+    }
+    bool active() const {
+        int current = load_state();
+        return current == XFER_ACTIVE || current == XFER_DONE;
+    }
+};
+
+class Transport {
+public:
+    virtual ~Transport() {}
+    virtual const char* name() const = 0;
+
+    // bufferul unei trimiteri poate fi refolosit dupa wait
+    virtual void isend(const void* buf, int len, int dest, int tag, xfer_request& req) = 0;
+    virtual void send(const void* buf, int len, int dest, int tag) = 0;
+    virtual void irecv(void* buf, int len, int source, int tag, xfer_request& req) = 0;
+    // receive de dimensiune necunoscuta (terminat doar de wait sau test, nu de waitsome)
+    virtual void irecv_packed(std::vector<char>& buf, int source, int tag, xfer_request& req) = 0;
+    // receive persistent: descris o data, pornit cu start dupa fiecare mesaj primit
+    virtual void recv_init(void* buf, int len, int source, int tag, xfer_request& req) = 0;
+    virtual void start(xfer_request& req) = 0;
+    /* anuleaza un receive neterminat si elibereaza request-ul (si pe cel persistent); intoarce
+    true daca niciun mesaj nu a apucat sa fie primit in el (mesajul, daca vine, ramane nepotrivit) */
+    virtual bool cancel(xfer_request& req) = 0;
+    virtual void wait(xfer_request& req, xfer_status* status) = 0;
+    // ca wait, dar cel mult "timeout_ms"; true daca operatia s-a terminat (si e raportata, ca la test)
+    virtual bool wait_for(xfer_request& req, int timeout_ms, xfer_status* status) = 0;
+    // true daca operatia activa s-a terminat (si e raportata), fara sa astepte
+    virtual bool test(xfer_request& req, xfer_status* status) = 0;
+    // asteapta sa se termine cel putin una dintre operatiile active; nr_done = 0 daca nu e niciuna
+    virtual void waitsome(int n, xfer_request* reqs, int& nr_done, int* indices, xfer_status* statuses) = 0;
+
+    // un mesaj de dimensiune necunoscuta, blocant
+    void recv_packed(std::vector<char>& buf, int source, int tag) {
+        xfer_request req;
+        irecv_packed(buf, source, tag, req);
+        wait(req, nullptr);
+    }
+};
+
+// "owned": comunicatorul e al transportului si se elibereaza odata cu el
+class MpiTransport : public Transport {
+public:
+    MpiTransport(MPI_Comm comm, bool owned);
+    ~MpiTransport();
+    const char* name() const {
+        return "mpi";
+    }
+    MPI_Comm communicator() const {
+        return comm;
+    }
+
+    void isend(const void* buf, int len, int dest, int tag, xfer_request& req);
+    void send(const void* buf, int len, int dest, int tag);
+    void irecv(void* buf, int len, int source, int tag, xfer_request& req);
+    void irecv_packed(std::vector<char>& buf, int source, int tag, xfer_request& req);
+    void recv_init(void* buf, int len, int source, int tag, xfer_request& req);
+    void start(xfer_request& req);
+    bool cancel(xfer_request& req);
+    void wait(xfer_request& req, xfer_status* status);
+    bool wait_for(xfer_request& req, int timeout_ms, xfer_status* status);
+    bool test(xfer_request& req, xfer_status* status);
+    void waitsome(int n, xfer_request* reqs, int& nr_done, int* indices, xfer_status* statuses);
+
+private:
+    MPI_Comm comm;
+    bool owned;
+};
+
+// canalele unui rank in memoria partajata, fiecare cu un singur consumator
+#define SHM_CHANNEL_UPLOAD   0 // cereri de chunk si stop-ul de la tracker (thread-ul de upload)
+#define SHM_CHANNEL_DOWNLOAD 1 // raspunsuri si payload (thread-ul de download)
+#define SHM_NR_CHANNELS      2
+
+/* un inel are cel putin atatia octeti si incape in el cel putin SHM_RING_MIN_MESSAGES mesaje;
+mesajele mai lungi de SHM_FRAGMENT_BYTES (cu antet) sunt trimise in fragmente, deci memoria
+inelelor nu creste cu --chunk-size */
+#define SHM_CELL_SIZE 64
+#define SHM_RING_MIN_BYTES (256 * 1024)
+#define SHM_RING_MIN_MESSAGES 4
+#define SHM_FRAGMENT_BYTES (256 * 1024)
+
+struct shm_ring;
+
+// un mesaj sosit inaintea receive-ului lui
+struct shm_message {
+    int source;
+    int tag;
+    std::vector<char> data;
+};
+
+/* fiecare (rank, canal) are o coada MPSC in segmentul partajat (shm_open + mmap), in care
+oricare alt rank scrie fara lock-uri; consumatorul copiaza mesajul direct in bufferul
+receive-ului potrivit, sau il pastreaza pana la postarea lui (vezi transport.cpp) */
+class ShmTransport : public Transport {
+public:
+    ShmTransport(int rank, int numtasks);
+    ~ShmTransport();
+    const char* name() const {
+        return "shm";
+    }
+
+    bool open(int max_msg);
+
+    void isend(const void* buf, int len, int dest, int tag, xfer_request& req);
+    void send(const void* buf, int len, int dest, int tag);
+    void irecv(void* buf, int len, int source, int tag, xfer_request& req);
+    void irecv_packed(std::vector<char>& buf, int source, int tag, xfer_request& req);
+    void recv_init(void* buf, int len, int source, int tag, xfer_request& req);
+    void start(xfer_request& req);
+    bool cancel(xfer_request& req);
+    void wait(xfer_request& req, xfer_status* status);
+    bool wait_for(xfer_request& req, int timeout_ms, xfer_status* status);
+    bool test(xfer_request& req, xfer_status* status);
+    void waitsome(int n, xfer_request* reqs, int& nr_done, int* indices, xfer_status* statuses);
+
+private:
+    // un mesaj fragmentat, primit pe jumatate: intr-un receive deja potrivit sau in "data"
+    struct partial {
+        xfer_request* match;
+        std::vector<char> data;
+        char* dst;
+        int total;
+        int received;
+    };
+
+    // starea locala a unui canal al nostru, atinsa doar de thread-ul care il consuma
+    struct channel {
+        uint64_t head;
+        std::vector<xfer_request*> posted;
+        std::deque<shm_message> unexpected;
+        std::vector<partial> partials; // cate unul pentru fiecare sursa
+    };
+
+    int rank;
+    int numtasks;
+    char* base;
+    size_t size;
+    uint64_t nr_cells;
+    channel channels[SHM_NR_CHANNELS];
+
+    shm_ring ring(int rank, int ch);
+    bool try_push(int dest, int tag, const void* buf, int len, int total, int offset);
+    void push(int dest, int tag, const void* buf, int len);
+    bool pop(int ch);
+    bool assembling(int ch, const xfer_request* req) const;
+    void truncated(int len, int posted_len) const;
+    void progress(int ch);
+    void sleep_until_ready(int ch, long timeout_ns);
+    void complete(xfer_request& req, int source, int count);
+    void collect(xfer_request& req, xfer_status* status);
+};
+
+/* colectiv pe MPI_COMM_WORLD: "kind" e "mpi", "shm" sau "auto" (shm daca toate rank-urile sunt
+pe acelasi nod si segmentul se poate aloca, altfel MPI); max_msg e cel mai mare payload trimis */
+Transport* create_transport(const char* kind, int max_msg);
+
+// ceasul monoton al termenelor din wait_for
+uint64_t xfer_now_ns();